@@ -52,6 +52,8 @@ uint32_t curr_cflags(CPUState *cpu)
         cflags |= CF_NO_GOTO_TB | 1;
     } else if (qemu_loglevel_mask(CPU_LOG_TB_NOCHAIN)) {
         cflags |= CF_NO_GOTO_TB;
+    } else if (qatomic_read(&tcg_superblocks)) {
+        cflags |= CF_TRACE;
     }
 
     return cflags;
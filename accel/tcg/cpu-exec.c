@@ -24,11 +24,15 @@
 #include "hw/core/cpu.h"
 #include "accel/tcg/cpu-ops.h"
 #include "accel/tcg/helper-retaddr.h"
+#include "accel/tcg/cpu-mmu-index.h"
+#include "accel/tcg/probe.h"
 #include "trace.h"
 #include "disas/disas.h"
 #include "exec/cpu-common.h"
 #include "exec/cpu-interrupt.h"
 #include "exec/page-protection.h"
+#include "exec/target_page.h"
+#include "exec/tlb-flags.h"
 #include "exec/mmap-lock.h"
 #include "exec/translation-block.h"
 #include "tcg/tcg.h"
@@ -209,6 +213,59 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, TCGTBCPUState s)
     return qht_lookup_custom(&tb_ctx.htable, &desc, h, tb_lookup_cmp);
 }
 
+/* Lookups per sizing window of "-accel tcg,jmp-cache-grow=on". */
+#define TB_JMP_CACHE_WINDOW     (1 << 16)
+/* Grow when more than 1/N of the lookups in a window missed. */
+#define TB_JMP_CACHE_GROW_RATIO 8
+
+static CPUJumpCache *tb_jmp_cache_new(unsigned bits)
+{
+    CPUJumpCache *jc;
+
+    jc = g_malloc0(sizeof(*jc) + (sizeof(jc->array[0]) << bits));
+    jc->bits = bits;
+    return jc;
+}
+
+/*
+ * Account a jump cache miss that the htable could satisfy.  Returns the
+ * cache to use from now on, which is a new and larger one if the miss
+ * rate over the last window was too high.  Must be called by the CPU
+ * owning @jc.
+ */
+static CPUJumpCache *tb_jmp_cache_miss(CPUState *cpu, CPUJumpCache *jc)
+{
+    CPUJumpCache *new_jc;
+    size_t lookups, misses;
+
+    qatomic_set(&jc->misses, jc->misses + 1);
+
+    if (!qatomic_read(&tcg_jmp_cache_grow) ||
+        jc->bits >= TB_JMP_CACHE_GROW_MAX) {
+        return jc;
+    }
+    lookups = jc->hits + jc->misses - jc->window_lookups;
+    if (lookups < TB_JMP_CACHE_WINDOW) {
+        return jc;
+    }
+    misses = jc->misses - jc->window_misses;
+    jc->window_lookups += lookups;
+    jc->window_misses += misses;
+    if (misses * TB_JMP_CACHE_GROW_RATIO < lookups) {
+        return jc;
+    }
+
+    /* The new cache starts empty; it refills from the htable. */
+    new_jc = tb_jmp_cache_new(jc->bits + 1);
+    new_jc->hits = jc->hits;
+    new_jc->misses = jc->misses;
+    new_jc->window_lookups = jc->window_lookups;
+    new_jc->window_misses = jc->window_misses;
+    qatomic_rcu_set(&cpu->tb_jmp_cache, new_jc);
+    g_free_rcu(jc, rcu);
+    return new_jc;
+}
+
 /**
  * tb_lookup:
  * @cpu: CPU that will execute the returned translation block
@@ -232,8 +289,8 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, TCGTBCPUState s)
     /* we should never be trying to look up an INVALID tb */
     tcg_debug_assert(!(s.cflags & CF_INVALID));
 
-    hash = tb_jmp_cache_hash_func(s.pc);
     jc = cpu->tb_jmp_cache;
+    hash = tb_jmp_cache_hash_func(jc, s.pc);
 
     tb = qatomic_read(&jc->array[hash].tb);
     if (likely(tb &&
@@ -241,6 +298,7 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, TCGTBCPUState s)
                tb->cs_base == s.cs_base &&
                tb->flags == s.flags &&
                tb_cflags(tb) == s.cflags)) {
+        qatomic_set(&jc->hits, jc->hits + 1);
         goto hit;
     }
 
@@ -249,6 +307,8 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, TCGTBCPUState s)
         return NULL;
     }
 
+    jc = tb_jmp_cache_miss(cpu, jc);
+    hash = tb_jmp_cache_hash_func(jc, s.pc);
     jc->array[hash].pc = s.pc;
     qatomic_set(&jc->array[hash].tb, tb);
 
@@ -596,6 +656,143 @@ void cpu_exec_step_atomic(CPUState *cpu)
     end_exclusive();
 }
 
+/*
+ * Successor pre-translation, see "-accel tcg,prefetch=on".
+ *
+ * While translating, the static goto_tb destinations of each block are
+ * noted in a small per-thread stack.  When an MTTCG vCPU thread is about
+ * to go idle, it translates those that are not in tb_ctx.htable yet, so
+ * that the guest does not pay for them when it resumes.  The work stays
+ * on the vCPU thread: translation needs that thread's tcg_ctx region and
+ * the vCPU's softmmu TLB.
+ */
+#define TB_PREFETCH_SIZE        16
+/* Longest guest insn of any target; the first insn may cross a page. */
+#define TB_PREFETCH_INSN_MAX    16
+
+typedef struct TBPrefetch {
+    vaddr pc;
+    uint64_t cs_base;
+    uint32_t flags;
+} TBPrefetch;
+
+static __thread TBPrefetch tb_prefetch_stack[TB_PREFETCH_SIZE];
+static __thread unsigned tb_prefetch_top, tb_prefetch_depth;
+
+void tb_prefetch_note(const TranslationBlock *tb, vaddr dest)
+{
+    TBPrefetch *p;
+
+    /* Not for single-stepping and other size-limited blocks. */
+    if (tb_cflags(tb) & CF_COUNT_MASK) {
+        return;
+    }
+
+    /* When full, the oldest entry is overwritten. */
+    p = &tb_prefetch_stack[tb_prefetch_top++ % TB_PREFETCH_SIZE];
+    p->pc = dest;
+    p->cs_base = tb->cs_base;
+    p->flags = tb->flags;
+    if (tb_prefetch_depth < TB_PREFETCH_SIZE) {
+        tb_prefetch_depth++;
+    }
+}
+
+#ifndef CONFIG_USER_ONLY
+static bool tb_prefetch_pop(TCGTBCPUState *s)
+{
+    TBPrefetch *p;
+
+    if (tb_prefetch_depth == 0) {
+        return false;
+    }
+    tb_prefetch_depth--;
+    p = &tb_prefetch_stack[--tb_prefetch_top % TB_PREFETCH_SIZE];
+    s->pc = p->pc;
+    s->cs_base = p->cs_base;
+    s->flags = p->flags;
+    return true;
+}
+
+/* Is @addr executable RAM, without raising a fault to find out? */
+static bool tb_prefetch_probe(CPUState *cpu, vaddr addr)
+{
+    CPUTLBEntryFull *full;
+    void *host;
+    int flags;
+
+    flags = probe_access_full(cpu_env(cpu), addr, 1, MMU_INST_FETCH,
+                              cpu_mmu_index(cpu, true), true,
+                              &host, &full, 0);
+    return !(flags & TLB_INVALID_MASK) && host != NULL &&
+           full->lg_page_size >= TARGET_PAGE_BITS;
+}
+
+static bool tb_prefetch_one(CPUState *cpu, TCGTBCPUState s)
+{
+    vaddr last = s.pc + TB_PREFETCH_INSN_MAX - 1;
+
+    /* tb_htable_lookup() may fault, so probe first. */
+    if (!tb_prefetch_probe(cpu, s.pc)) {
+        return false;
+    }
+    if (((last ^ s.pc) & TARGET_PAGE_MASK) && !tb_prefetch_probe(cpu, last)) {
+        return false;
+    }
+    if (tb_htable_lookup(cpu, s)) {
+        return false;
+    }
+    tb_gen_code(cpu, s);
+    return true;
+}
+
+/*
+ * Called with the BQL held by an MTTCG vCPU thread that has nothing to
+ * execute.  Stops as soon as the vCPU is kicked.
+ */
+void tb_prefetch_run(CPUState *cpu)
+{
+    TCGTBCPUState s;
+
+    if (tb_prefetch_depth == 0) {
+        return;
+    }
+
+    bql_unlock();
+    /* Keep tb_flush() and other exclusive work out while we translate. */
+    cpu_exec_start(cpu);
+    rcu_read_lock();
+
+    if (sigsetjmp(cpu->jmp_env, 0) == 0) {
+        /* New blocks note their own successors; bound the chain. */
+        int budget = TB_PREFETCH_SIZE;
+
+        while (budget && !qatomic_read(&cpu->exit_request) &&
+               tb_prefetch_pop(&s)) {
+            s.cflags = curr_cflags(cpu);
+            if (tb_prefetch_one(cpu, s)) {
+                stat64_add(&tb_ctx.tb_prefetch_count, 1);
+                budget--;
+            }
+        }
+    } else {
+        /*
+         * A fault past the first page of a block, or a full code buffer
+         * (the flush is already queued).  Nothing is delivered to the
+         * guest; drop what is left.
+         */
+        cpu_exec_longjmp_cleanup(cpu);
+        cpu->exception_index = -1;
+        tb_prefetch_depth = 0;
+        stat64_add(&tb_ctx.tb_prefetch_abort_count, 1);
+    }
+
+    rcu_read_unlock();
+    cpu_exec_end(cpu);
+    bql_lock();
+}
+#endif
+
 void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr)
 {
     /*
@@ -957,8 +1154,8 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                  * We add the TB in the virtual pc hash table
                  * for the fast lookup
                  */
-                h = tb_jmp_cache_hash_func(s.pc);
                 jc = cpu->tb_jmp_cache;
+                h = tb_jmp_cache_hash_func(jc, s.pc);
                 jc->array[h].pc = s.pc;
                 qatomic_set(&jc->array[h].tb, tb);
             }
@@ -1048,7 +1245,7 @@ bool tcg_exec_realizefn(CPUState *cpu, Error **errp)
         tcg_target_initialized = true;
     }
 
-    cpu->tb_jmp_cache = g_new0(CPUJumpCache, 1);
+    cpu->tb_jmp_cache = tb_jmp_cache_new(tcg_jmp_cache_bits);
     tlb_init(cpu);
 #ifndef CONFIG_USER_ONLY
     tcg_iommu_init_notifier_list(cpu);
@@ -157,8 +157,8 @@ static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
         return;
     }
 
-    i0 = tb_jmp_cache_hash_page(page_addr);
-    for (i = 0; i < TB_JMP_PAGE_SIZE; i++) {
+    i0 = tb_jmp_cache_hash_page(jc, page_addr);
+    for (i = 0; i < tb_jmp_page_size(jc); i++) {
         qatomic_set(&jc->array[i0 + i].tb, NULL);
     }
 }
@@ -286,6 +286,8 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->vindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
     memset(desc->vtable, -1, sizeof(desc->vtable));
+    desc->lindex = 0;
+    memset(desc->laddr, -1, sizeof(desc->laddr));
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -741,7 +743,8 @@ static void tlb_flush_range_by_mmuidx_async_0(CPUState *cpu,
      * If the length is larger than the jump cache size, then it will take
      * longer to clear each entry individually than it will to clear it all.
      */
-    if (d.len >= (TARGET_PAGE_SIZE * TB_JMP_CACHE_SIZE)) {
+    if (!cpu->tb_jmp_cache ||
+        d.len >= TARGET_PAGE_SIZE * tb_jmp_cache_size(cpu->tb_jmp_cache)) {
         tcg_flush_jmp_cache(cpu);
         return;
     }
@@ -1014,6 +1017,35 @@ static inline void tlb_set_compare(CPUTLBEntryFull *full, CPUTLBEntry *ent,
     full->slow_flags[access_type] = flags;
 }
 
+/*
+ * Remember the translation of the large page containing @addr.  Any
+ * flush that touches the page flushes the whole mmu_idx, see
+ * tlb_add_large_page(), which forgets it again.
+ * Called with tlb_c.lock held.
+ */
+static void tlb_record_large_page(CPUTLBDesc *desc, vaddr addr,
+                                  const CPUTLBEntryFull *full)
+{
+    vaddr lp_mask = ~(((vaddr)1 << full->lg_page_size) - 1);
+    vaddr lp_addr = addr & lp_mask;
+    unsigned lidx;
+
+    for (lidx = 0; lidx < CPU_LTLB_SIZE; lidx++) {
+        if (desc->laddr[lidx] == lp_addr &&
+            desc->lfulltlb[lidx].lg_page_size == full->lg_page_size) {
+            break;
+        }
+    }
+    if (lidx == CPU_LTLB_SIZE) {
+        lidx = desc->lindex++ % CPU_LTLB_SIZE;
+    }
+
+    desc->laddr[lidx] = lp_addr;
+    desc->lfulltlb[lidx] = *full;
+    desc->lfulltlb[lidx].phys_addr = (full->phys_addr & TARGET_PAGE_MASK)
+                                     - ((addr & ~lp_mask) & TARGET_PAGE_MASK);
+}
+
 /*
  * Add a new TLB entry. At most one entry for a given virtual address
  * is permitted. Only a single TARGET_PAGE_SIZE region is mapped, the
@@ -1121,6 +1153,13 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
     /* Note that the tlb is no longer clean.  */
     tlb->c.dirty |= 1 << mmu_idx;
 
+    /* Targets see every write to PAGE_WRITE_INV pages; never skip them. */
+    if (cpu->cc->tcg_ops->large_page_refill &&
+        full->lg_page_size > TARGET_PAGE_BITS &&
+        !(full->prot & PAGE_WRITE_INV)) {
+        tlb_record_large_page(desc, addr, full);
+    }
+
     /* Make sure there's no cached translation for the new page.  */
     tlb_flush_vtlb_page_locked(cpu, mmu_idx, addr_page);
 
@@ -1230,6 +1269,45 @@ static inline bool tlb_hit(uint64_t tlb_addr, vaddr addr)
     return tlb_hit_page(tlb_addr, addr & TARGET_PAGE_MASK);
 }
 
+/*
+ * Fill the entry for @addr from a large page recorded by
+ * tlb_record_large_page(), if one covers it with the permission
+ * needed for @type.  The target is not consulted, so anything it
+ * would do on a fill (fault, access or dirty bit update) must already
+ * have happened when the large page was first filled, which is why
+ * targets opt in with TCGCPUOps.large_page_refill.
+ */
+static bool tlb_fill_large_page(CPUState *cpu, vaddr addr,
+                                MMUAccessType type, int mmu_idx)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    int need = (type == MMU_INST_FETCH ? PAGE_EXEC :
+                type == MMU_DATA_STORE ? PAGE_WRITE : PAGE_READ);
+
+    if (!cpu->cc->tcg_ops->large_page_refill) {
+        return false;
+    }
+
+    for (unsigned lidx = 0; lidx < CPU_LTLB_SIZE; lidx++) {
+        CPUTLBEntryFull full = desc->lfulltlb[lidx];
+        vaddr lp_mask = ~(((vaddr)1 << full.lg_page_size) - 1);
+
+        if (desc->laddr[lidx] == -1 ||
+            (addr & lp_mask) != desc->laddr[lidx]) {
+            continue;
+        }
+        if (!(full.prot & need)) {
+            return false;
+        }
+        full.phys_addr += (addr & ~lp_mask) & TARGET_PAGE_MASK;
+        tlb_set_page_full(cpu, mmu_idx, addr, &full);
+        qatomic_set(&cpu->neg.tlb.c.large_fill_count,
+                    cpu->neg.tlb.c.large_fill_count + 1);
+        return true;
+    }
+    return false;
+}
+
 /*
  * Note: tlb_fill_align() can trigger a resize of the TLB.
  * This means that all of the caller's prior references to the TLB table
@@ -1244,6 +1322,11 @@ static bool tlb_fill_align(CPUState *cpu, vaddr addr, MMUAccessType type,
     CPUTLBEntryFull full;
 
     if (ops->tlb_fill_align) {
+        /* The target checks alignment against the page attributes. */
+        if (!memop_alignment_bits(memop) &&
+            tlb_fill_large_page(cpu, addr, type, mmu_idx)) {
+            return true;
+        }
         if (ops->tlb_fill_align(cpu, &full, addr, type, mmu_idx,
                                 memop, size, probe, ra)) {
             tlb_set_page_full(cpu, mmu_idx, addr, &full);
@@ -1254,6 +1337,9 @@ static bool tlb_fill_align(CPUState *cpu, vaddr addr, MMUAccessType type,
         if (addr & ((1u << memop_alignment_bits(memop)) - 1)) {
             ops->do_unaligned_access(cpu, addr, type, mmu_idx, ra);
         }
+        if (tlb_fill_large_page(cpu, addr, type, mmu_idx)) {
+            return true;
+        }
         if (ops->tlb_fill(cpu, addr, size, type, mmu_idx, probe, ra)) {
             return true;
         }
@@ -18,6 +18,10 @@ extern int64_t max_delay;
 extern int64_t max_advance;
 
 extern bool one_insn_per_tb;
+extern bool tcg_superblocks;
+extern bool tcg_prefetch;
+extern unsigned tcg_jmp_cache_bits;
+extern bool tcg_jmp_cache_grow;
 
 extern bool icount_align_option;
 
@@ -48,6 +52,8 @@ static inline bool cpu_plugin_mem_cbs_enabled(const CPUState *cpu)
 }
 
 TranslationBlock *tb_gen_code(CPUState *cpu, TCGTBCPUState s);
+void tb_prefetch_note(const TranslationBlock *tb, vaddr dest);
+void tb_prefetch_run(CPUState *cpu);
 void page_init(void);
 void tb_htable_init(void);
 void tb_reset_jump(TranslationBlock *tb, int n);
@@ -248,6 +248,126 @@ static void gen_mem_cb(struct qemu_plugin_regular_cb *cb,
     tcg_temp_free_i32(clear_flags);
 }
 
+#define MEM_RECORD_OFS(field)                                   \
+    (offsetof(struct qemu_plugin_mem_buffer_slot, records) +    \
+     offsetof(qemu_plugin_mem_record, field))
+
+/* Flush @buf unless it has room for @sites more records */
+static void gen_mem_buffer_check(struct qemu_plugin_buffered_cb *cb,
+                                 unsigned int sites)
+{
+    qemu_plugin_u64 entry = { .score = cb->buf->score };
+    TCGv_ptr slot = gen_plugin_u64_ptr(entry);
+    TCGv_i64 count = tcg_temp_ebb_new_i64();
+    TCGLabel *after_flush = gen_new_label();
+
+    g_assert(sites <= cb->buf->capacity);
+
+    tcg_gen_ld_i64(count, slot,
+                   offsetof(struct qemu_plugin_mem_buffer_slot, count));
+    tcg_gen_brcondi_i64(TCG_COND_LEU, count, cb->buf->capacity - sites,
+                        after_flush);
+    TCGv_i32 cpu_index = gen_cpu_index();
+    tcg_gen_call2(qemu_plugin_mem_buffer_flush, cb->info, NULL,
+                  tcgv_i32_temp(cpu_index),
+                  tcgv_ptr_temp(tcg_constant_ptr(cb->buf)));
+    tcg_temp_free_i32(cpu_index);
+    gen_set_label(after_flush);
+
+    tcg_temp_free_i64(count);
+    tcg_temp_free_ptr(slot);
+}
+
+static void gen_mem_buffer_append(struct qemu_plugin_buffered_cb *cb,
+                                  qemu_plugin_meminfo_t meminfo,
+                                  TCGv_i64 addr)
+{
+    qemu_plugin_u64 entry = { .score = cb->buf->score };
+    TCGv_ptr slot = gen_plugin_u64_ptr(entry);
+    TCGv_ptr rec = tcg_temp_ebb_new_ptr();
+    TCGv_i64 count = tcg_temp_ebb_new_i64();
+    TCGv_i64 ofs = tcg_temp_ebb_new_i64();
+
+    QEMU_BUILD_BUG_ON(sizeof(qemu_plugin_mem_record) != 16);
+
+    tcg_gen_ld_i64(count, slot,
+                   offsetof(struct qemu_plugin_mem_buffer_slot, count));
+    tcg_gen_shli_i64(ofs, count, 4);
+    tcg_gen_trunc_i64_ptr(rec, ofs);
+    tcg_gen_add_ptr(rec, rec, slot);
+    tcg_gen_st_i64(addr, rec, MEM_RECORD_OFS(vaddr));
+    tcg_gen_st_i32(tcg_constant_i32(meminfo), rec, MEM_RECORD_OFS(info));
+    tcg_gen_st_i32(tcg_constant_i32(cb->tag), rec, MEM_RECORD_OFS(tag));
+    tcg_gen_addi_i64(count, count, 1);
+    tcg_gen_st_i64(count, slot,
+                   offsetof(struct qemu_plugin_mem_buffer_slot, count));
+
+    tcg_temp_free_i64(ofs);
+    tcg_temp_free_i64(count);
+    tcg_temp_free_ptr(rec);
+    tcg_temp_free_ptr(slot);
+}
+
+static unsigned int mem_buffer_sites(struct qemu_plugin_insn *insn,
+                                     struct qemu_plugin_buffered_cb *cb)
+{
+    unsigned int sites = 0;
+
+    if (cb->rw & QEMU_PLUGIN_MEM_R) {
+        sites += insn->mem_sites[false];
+    }
+    if (cb->rw & QEMU_PLUGIN_MEM_W) {
+        sites += insn->mem_sites[true];
+    }
+    return sites;
+}
+
+/*
+ * The appends at each memory access cannot branch, as the guest code
+ * around them may keep values in EBB temps.  Instead, make room for
+ * all the accesses of the instruction before it starts.
+ */
+static void gen_mem_buffer_checks(struct qemu_plugin_insn *insn)
+{
+    const GArray *cbs = insn->mem_cbs;
+    int i, j, n = cbs ? cbs->len : 0;
+
+    for (i = 0; i < n; i++) {
+        struct qemu_plugin_dyn_cb *cb =
+            &g_array_index(cbs, struct qemu_plugin_dyn_cb, i);
+        unsigned int sites;
+
+        if (cb->type != PLUGIN_CB_MEM_BUFFERED) {
+            continue;
+        }
+        /* Several registrations may share a buffer: check it once. */
+        for (j = 0; j < i; j++) {
+            struct qemu_plugin_dyn_cb *prev =
+                &g_array_index(cbs, struct qemu_plugin_dyn_cb, j);
+            if (prev->type == PLUGIN_CB_MEM_BUFFERED &&
+                prev->buffered.buf == cb->buffered.buf) {
+                break;
+            }
+        }
+        if (j < i) {
+            continue;
+        }
+
+        sites = mem_buffer_sites(insn, &cb->buffered);
+        for (j = i + 1; j < n; j++) {
+            struct qemu_plugin_dyn_cb *next =
+                &g_array_index(cbs, struct qemu_plugin_dyn_cb, j);
+            if (next->type == PLUGIN_CB_MEM_BUFFERED &&
+                next->buffered.buf == cb->buffered.buf) {
+                sites += mem_buffer_sites(insn, &next->buffered);
+            }
+        }
+        if (sites) {
+            gen_mem_buffer_check(&cb->buffered, sites);
+        }
+    }
+}
+
 static void inject_cb(struct qemu_plugin_dyn_cb *cb)
 
 {
@@ -279,6 +399,11 @@ static void inject_mem_cb(struct qemu_plugin_dyn_cb *cb,
             gen_mem_cb(&cb->regular, meminfo, addr);
         }
         break;
+    case PLUGIN_CB_MEM_BUFFERED:
+        if (rw & cb->buffered.rw) {
+            gen_mem_buffer_append(&cb->buffered, meminfo, addr);
+        }
+        break;
     case PLUGIN_CB_INLINE_ADD_U64:
     case PLUGIN_CB_INLINE_STORE_U64:
         if (rw & cb->inline_insn.rw) {
@@ -290,6 +415,29 @@ static void inject_mem_cb(struct qemu_plugin_dyn_cb *cb,
     }
 }
 
+/* Count the memory accesses of each instruction, for the buffered cbs */
+static void plugin_gen_count_mem_sites(struct qemu_plugin_tb *plugin_tb)
+{
+    struct qemu_plugin_insn *insn = NULL;
+    TCGOp *op;
+    int insn_idx = -1;
+
+    QTAILQ_FOREACH(op, &tcg_ctx->ops, link) {
+        switch (op->opc) {
+        case INDEX_op_insn_start:
+            insn_idx++;
+            insn = g_ptr_array_index(plugin_tb->insns, insn_idx);
+            break;
+        case INDEX_op_plugin_mem_cb:
+            assert(insn != NULL);
+            insn->mem_sites[qemu_plugin_mem_is_store(op->args[1])]++;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 static void plugin_gen_inject(struct qemu_plugin_tb *plugin_tb)
 {
     TCGOp *op, *next;
@@ -313,6 +461,8 @@ static void plugin_gen_inject(struct qemu_plugin_tb *plugin_tb)
      */
     tcg_temp_ebb_reset_freed(tcg_ctx);
 
+    plugin_gen_count_mem_sites(plugin_tb);
+
     QTAILQ_FOREACH_SAFE(op, &tcg_ctx->ops, link, next) {
         switch (op->opc) {
         case INDEX_op_insn_start:
@@ -360,6 +510,7 @@ static void plugin_gen_inject(struct qemu_plugin_tb *plugin_tb)
                 assert(insn != NULL);
 
                 gen_enable_mem_helper(plugin_tb, insn);
+                gen_mem_buffer_checks(insn);
 
                 cbs = insn->insn_cbs;
                 for (i = 0, n = (cbs ? cbs->len : 0); i < n; i++) {
@@ -416,6 +567,8 @@ bool plugin_gen_tb_start(CPUState *cpu, const DisasContextBase *db)
     struct qemu_plugin_tb *ptb;
 
     if (!test_bit(QEMU_PLUGIN_EV_VCPU_TB_TRANS,
+                  cpu->plugin_state->event_mask) &&
+        !test_bit(QEMU_PLUGIN_EV_VCPU_SAMPLE,
                   cpu->plugin_state->event_mask)) {
         return false;
     }
@@ -461,6 +614,7 @@ void plugin_gen_insn_start(CPUState *cpu, const DisasContextBase *db)
     tcg_ctx->plugin_insn = insn;
     insn->calls_helpers = false;
     insn->mem_helper = false;
+    insn->mem_sites[false] = insn->mem_sites[true] = 0;
     if (insn->insn_cbs) {
         g_array_set_size(insn->insn_cbs, 0);
     }
@@ -22,6 +22,7 @@
 
 #include "qemu/thread.h"
 #include "qemu/qht.h"
+#include "qemu/stats64.h"
 
 #define CODE_GEN_HTABLE_BITS     15
 #define CODE_GEN_HTABLE_SIZE     (1 << CODE_GEN_HTABLE_BITS)
@@ -35,6 +36,14 @@ struct TBContext {
     /* statistics */
     unsigned tb_flush_count;
     unsigned tb_phys_invalidate_count;
+
+    /* writes to pages with code, see tb_invalidate_phys_range_fast() */
+    Stat64 tb_smc_write_count;
+    Stat64 tb_smc_skip_count;
+
+    /* idle-time successor translation, see tb_prefetch_run() */
+    Stat64 tb_prefetch_count;
+    Stat64 tb_prefetch_abort_count;
 };
 
 extern TBContext tb_ctx;
@@ -12,8 +12,21 @@
 #include "qemu/rcu.h"
 #include "exec/cpu-common.h"
 
-#define TB_JMP_CACHE_BITS 12
-#define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
+/*
+ * Default and limits for "-accel tcg,jmp-cache-bits=N".  The softmmu
+ * hash uses half of the bits for the page number, which must not
+ * exceed the smallest target page size.
+ */
+#define TB_JMP_CACHE_BITS       12
+#define TB_JMP_CACHE_BITS_MIN   8
+#define TB_JMP_CACHE_BITS_MAX   16
+
+/*
+ * Limit for "-accel tcg,jmp-cache-grow=on".  tcg_flush_jmp_cache() clears
+ * the whole cache, and invalidating a CF_PCREL TB does that on every vCPU,
+ * so a grown cache must stay cheap to flush.
+ */
+#define TB_JMP_CACHE_GROW_MAX   14
 
 /*
  * Invalidated in parallel; all accesses to 'tb' must be atomic.
@@ -21,13 +34,29 @@
  * no need for qatomic_rcu_read() and pc is always consistent with a
  * non-NULL value of 'tb'.  Strictly speaking pc is only needed for
  * CF_PCREL, but it's used always for simplicity.
+ *
+ * The cache may be replaced by a larger one by its own CPU, see
+ * tb_jmp_cache_miss(); other threads must use qatomic_rcu_read() on
+ * cpu->tb_jmp_cache within an RCU read-side critical section.
  */
 typedef struct CPUJumpCache {
     struct rcu_head rcu;
+    unsigned bits;
+    /* statistics, written by the owning CPU only */
+    size_t hits;
+    size_t misses;
+    /* start of the current sizing window */
+    size_t window_lookups;
+    size_t window_misses;
     struct {
         TranslationBlock *tb;
         vaddr pc;
-    } array[TB_JMP_CACHE_SIZE];
+    } array[];
 } CPUJumpCache;
 
+static inline size_t tb_jmp_cache_size(const CPUJumpCache *jc)
+{
+    return (size_t)1 << jc->bits;
+}
+
 #endif /* ACCEL_TCG_TB_JMP_CACHE_H */
@@ -18,6 +18,7 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/bitmap.h"
 #include "qemu/interval-tree.h"
 #include "qemu/qtree.h"
 #include "exec/cputlb.h"
@@ -180,10 +181,20 @@ static int v_l2_levels;
 
 static void *l1_map[V_L1_MAX_SIZE];
 
+/*
+ * Once a page with code has taken this many writes, track which of its
+ * bytes back translated code, so that writes to data that shares the
+ * page with code need not walk the TB list.
+ */
+#define SMC_BITMAP_USE_THRESHOLD 10
+
 struct PageDesc {
     QemuSpin lock;
     /* list of TBs intersecting this ram page */
     uintptr_t first_tb;
+    /* bytes of the page covered by TBs, or NULL if not built yet */
+    unsigned long *code_bitmap;
+    unsigned int code_write_count;
 };
 
 void page_table_config_init(void)
@@ -651,6 +662,74 @@ static void page_collection_unlock(struct page_collection *set)
     g_free(set);
 }
 
+/*
+ * The range of @tb's code within the page it is linked into as page @n.
+ * A TB may span two physical pages.
+ */
+static void tb_page_range(TranslationBlock *tb, unsigned int n,
+                          tb_page_addr_t *pstart, tb_page_addr_t *plast)
+{
+    tb_page_addr_t tb_start, tb_last;
+
+    tb_start = tb_page_addr0(tb);
+    tb_last = tb_start + tb->size - 1;
+    if (n == 0) {
+        tb_last = MIN(tb_last, tb_start | ~TARGET_PAGE_MASK);
+    } else {
+        tb_start = tb_page_addr1(tb);
+        tb_last = tb_start + (tb_last & ~TARGET_PAGE_MASK);
+    }
+    *pstart = tb_start;
+    *plast = tb_last;
+}
+
+static void page_invalidate_code_bitmap(PageDesc *pd)
+{
+    g_free(pd->code_bitmap);
+    pd->code_bitmap = NULL;
+    pd->code_write_count = 0;
+}
+
+static void page_code_bitmap_add(PageDesc *pd, TranslationBlock *tb,
+                                 unsigned int n)
+{
+    tb_page_addr_t start, last;
+
+    tb_page_range(tb, n, &start, &last);
+    bitmap_set(pd->code_bitmap, start & ~TARGET_PAGE_MASK, last - start + 1);
+}
+
+static void page_build_code_bitmap(PageDesc *pd)
+{
+    TranslationBlock *tb;
+    PageForEachNext n;
+
+    pd->code_bitmap = bitmap_new(TARGET_PAGE_SIZE);
+    PAGE_FOR_EACH_TB(unused, unused, pd, tb, n) {
+        page_code_bitmap_add(pd, tb, n);
+    }
+}
+
+/*
+ * May a write of @len bytes at @start modify translated code?
+ * Called with @pd->lock held.
+ */
+static bool page_code_write_hits(PageDesc *pd, tb_page_addr_t start,
+                                 unsigned len)
+{
+    unsigned long offset = start & ~TARGET_PAGE_MASK;
+
+    if (!pd->code_bitmap) {
+        /* Let the TB walk unprotect a page that has no code left. */
+        if (!pd->first_tb ||
+            ++pd->code_write_count < SMC_BITMAP_USE_THRESHOLD) {
+            return true;
+        }
+        page_build_code_bitmap(pd);
+    }
+    return find_next_bit(pd->code_bitmap, offset + len, offset) < offset + len;
+}
+
 /* Set to NULL all the 'first_tb' fields in all PageDescs. */
 static void tb_remove_all_1(int level, void **lp)
 {
@@ -665,6 +744,7 @@ static void tb_remove_all_1(int level, void **lp)
         for (i = 0; i < V_L2_SIZE; ++i) {
             page_lock(&pd[i]);
             pd[i].first_tb = (uintptr_t)NULL;
+            page_invalidate_code_bitmap(&pd[i]);
             page_unlock(&pd[i]);
         }
     } else {
@@ -698,6 +778,9 @@ static void tb_page_add(PageDesc *p, TranslationBlock *tb, unsigned int n)
     tb->page_next[n] = p->first_tb;
     page_already_protected = p->first_tb != 0;
     p->first_tb = (uintptr_t)tb | n;
+    if (p->code_bitmap) {
+        page_code_bitmap_add(p, tb, n);
+    }
 
     /*
      * If some code is already present, then the pages are already
@@ -734,6 +817,8 @@ static void tb_page_remove(PageDesc *pd, TranslationBlock *tb)
     PAGE_FOR_EACH_TB(unused, unused, pd, tb1, n1) {
         if (tb1 == tb) {
             *pprev = tb1->page_next[n1];
+            /* Other TBs may share the bytes; rebuild when needed. */
+            page_invalidate_code_bitmap(pd);
             return;
         }
         pprev = &tb1->page_next[n1];
@@ -886,10 +971,11 @@ static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
             tcg_flush_jmp_cache(cpu);
         }
     } else {
-        uint32_t h = tb_jmp_cache_hash_func(tb->pc);
+        RCU_READ_LOCK_GUARD();
 
         CPU_FOREACH(cpu) {
-            CPUJumpCache *jc = cpu->tb_jmp_cache;
+            CPUJumpCache *jc = qatomic_rcu_read(&cpu->tb_jmp_cache);
+            uint32_t h = tb_jmp_cache_hash_func(jc, tb->pc);
 
             if (qatomic_read(&jc->array[h].tb) == tb) {
                 qatomic_set(&jc->array[h].tb, NULL);
@@ -1119,15 +1205,7 @@ tb_invalidate_phys_page_range__locked(CPUState *cpu,
     PAGE_FOR_EACH_TB(start, last, p, tb, n) {
         tb_page_addr_t tb_start, tb_last;
 
-        /* NOTE: this is subtle as a TB may span two physical pages */
-        tb_start = tb_page_addr0(tb);
-        tb_last = tb_start + tb->size - 1;
-        if (n == 0) {
-            tb_last = MIN(tb_last, tb_start | ~TARGET_PAGE_MASK);
-        } else {
-            tb_start = tb_page_addr1(tb);
-            tb_last = tb_start + (tb_last & ~TARGET_PAGE_MASK);
-        }
+        tb_page_range(tb, n, &tb_start, &tb_last);
         if (!(tb_last < start || tb_start > last)) {
             if (unlikely(current_tb == tb) &&
                 (tb_cflags(current_tb) & CF_COUNT_MASK) != 1) {
@@ -1206,8 +1284,13 @@ void tb_invalidate_phys_range_fast(CPUState *cpu, ram_addr_t start,
         ram_addr_t last = start + len - 1;
         struct page_collection *pages = page_collection_lock(start, last);
 
-        tb_invalidate_phys_page_range__locked(cpu, pages, p,
-                                              start, last, ra);
+        stat64_add(&tb_ctx.tb_smc_write_count, 1);
+        if (page_code_write_hits(p, start, len)) {
+            tb_invalidate_phys_page_range__locked(cpu, pages, p,
+                                                  start, last, ra);
+        } else {
+            stat64_add(&tb_ctx.tb_smc_skip_count, 1);
+        }
         page_collection_unlock(pages);
     }
 }
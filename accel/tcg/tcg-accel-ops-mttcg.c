@@ -34,6 +34,7 @@
 #include "tcg/startup.h"
 #include "tcg-accel-ops.h"
 #include "tcg-accel-ops-mttcg.h"
+#include "internal-common.h"
 
 typedef struct MttcgForceRcuNotifier {
     Notifier notifier;
@@ -113,6 +114,9 @@ static void *mttcg_cpu_thread_fn(void *arg)
             }
         }
 
+        if (qatomic_read(&tcg_prefetch) && cpu_thread_is_idle(cpu)) {
+            tb_prefetch_run(cpu);
+        }
         qemu_wait_io_event(cpu);
     } while (!cpu->unplug || cpu_can_run(cpu));
 
@@ -43,6 +43,7 @@
 #include "accel/accel-cpu-ops.h"
 #include "accel/tcg/cpu-ops.h"
 #include "internal-common.h"
+#include "tb-jmp-cache.h"
 
 
 struct TCGState {
@@ -50,6 +51,10 @@ struct TCGState {
 
     OnOffAuto mttcg_enabled;
     bool one_insn_per_tb;
+    bool superblocks;
+    bool prefetch;
+    uint32_t jmp_cache_bits;
+    bool jmp_cache_grow;
     int splitwx_enabled;
     unsigned long tb_size;
 };
@@ -78,9 +83,14 @@ static void tcg_accel_instance_init(Object *obj)
 #else
     s->splitwx_enabled = 0;
 #endif
+    s->jmp_cache_bits = TB_JMP_CACHE_BITS;
 }
 
 bool one_insn_per_tb;
+bool tcg_superblocks;
+bool tcg_prefetch;
+unsigned tcg_jmp_cache_bits = TB_JMP_CACHE_BITS;
+bool tcg_jmp_cache_grow;
 
 static int tcg_init_machine(AccelState *as, MachineState *ms)
 {
@@ -195,6 +205,49 @@ static void tcg_set_tb_size(Object *obj, Visitor *v,
     s->tb_size = value;
 }
 
+static void tcg_get_jmp_cache_bits(Object *obj, Visitor *v,
+                                   const char *name, void *opaque,
+                                   Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value = s->jmp_cache_bits;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_jmp_cache_bits(Object *obj, Visitor *v,
+                                   const char *name, void *opaque,
+                                   Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value < TB_JMP_CACHE_BITS_MIN || value > TB_JMP_CACHE_BITS_MAX) {
+        error_setg(errp, "jmp-cache-bits must be between %d and %d",
+                   TB_JMP_CACHE_BITS_MIN, TB_JMP_CACHE_BITS_MAX);
+        return;
+    }
+
+    s->jmp_cache_bits = value;
+    tcg_jmp_cache_bits = value;
+}
+
+static bool tcg_get_jmp_cache_grow(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->jmp_cache_grow;
+}
+
+static void tcg_set_jmp_cache_grow(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->jmp_cache_grow = value;
+    qatomic_set(&tcg_jmp_cache_grow, value);
+}
+
 static bool tcg_get_splitwx(Object *obj, Error **errp)
 {
     TCGState *s = TCG_STATE(obj);
@@ -221,6 +274,32 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+static bool tcg_get_superblocks(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->superblocks;
+}
+
+static void tcg_set_superblocks(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->superblocks = value;
+    qatomic_set(&tcg_superblocks, value);
+}
+
+static bool tcg_get_prefetch(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->prefetch;
+}
+
+static void tcg_set_prefetch(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->prefetch = value;
+    qatomic_set(&tcg_prefetch, value);
+}
+
 static int tcg_gdbstub_supported_sstep_flags(AccelState *as)
 {
     /*
@@ -257,6 +336,17 @@ static void tcg_accel_class_init(ObjectClass *oc, const void *data)
     object_class_property_set_description(oc, "tb-size",
         "TCG translation block cache size");
 
+    object_class_property_add(oc, "jmp-cache-bits", "int",
+        tcg_get_jmp_cache_bits, tcg_set_jmp_cache_bits,
+        NULL, NULL);
+    object_class_property_set_description(oc, "jmp-cache-bits",
+        "log2 of the number of entries of each vCPU's TB jump cache");
+
+    object_class_property_add_bool(oc, "jmp-cache-grow",
+        tcg_get_jmp_cache_grow, tcg_set_jmp_cache_grow);
+    object_class_property_set_description(oc, "jmp-cache-grow",
+        "Grow a vCPU's TB jump cache when it misses too often");
+
     object_class_property_add_bool(oc, "split-wx",
         tcg_get_splitwx, tcg_set_splitwx);
     object_class_property_set_description(oc, "split-wx",
@@ -267,6 +357,20 @@ static void tcg_accel_class_init(ObjectClass *oc, const void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add_bool(oc, "superblocks",
+                                   tcg_get_superblocks,
+                                   tcg_set_superblocks);
+    object_class_property_set_description(oc, "superblocks",
+        "Let translation blocks continue past forward conditional "
+        "branches, where the target supports it");
+
+    object_class_property_add_bool(oc, "prefetch",
+                                   tcg_get_prefetch,
+                                   tcg_set_prefetch);
+    object_class_property_set_description(oc, "prefetch",
+        "Translate the static successors of recent blocks while a "
+        "vCPU is idle (multi-threaded TCG only)");
 }
 
 static const TypeInfo tcg_accel_type = {
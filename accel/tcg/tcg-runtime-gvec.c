@@ -21,6 +21,7 @@
 #include "qemu/host-utils.h"
 #include "exec/helper-proto-common.h"
 #include "tcg/tcg-gvec-desc.h"
+#include "qemu/gvec-accel.h"
 
 
 static inline void clear_high(void *d, intptr_t oprsz, uint32_t desc)
@@ -38,9 +39,9 @@ static inline void clear_high(void *d, intptr_t oprsz, uint32_t desc)
 void HELPER(gvec_add8)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_ADD8, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
+    for (; i < oprsz; i += sizeof(uint8_t)) {
         *(uint8_t *)(d + i) = *(uint8_t *)(a + i) + *(uint8_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -49,9 +50,9 @@ void HELPER(gvec_add8)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_add16)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_ADD16, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
+    for (; i < oprsz; i += sizeof(uint16_t)) {
         *(uint16_t *)(d + i) = *(uint16_t *)(a + i) + *(uint16_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -60,9 +61,9 @@ void HELPER(gvec_add16)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_add32)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_ADD32, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
+    for (; i < oprsz; i += sizeof(uint32_t)) {
         *(uint32_t *)(d + i) = *(uint32_t *)(a + i) + *(uint32_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -71,9 +72,9 @@ void HELPER(gvec_add32)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_add64)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_ADD64, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) + *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -126,9 +127,9 @@ void HELPER(gvec_adds64)(void *d, void *a, uint64_t b, uint32_t desc)
 void HELPER(gvec_sub8)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_SUB8, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
+    for (; i < oprsz; i += sizeof(uint8_t)) {
         *(uint8_t *)(d + i) = *(uint8_t *)(a + i) - *(uint8_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -137,9 +138,9 @@ void HELPER(gvec_sub8)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_sub16)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_SUB16, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
+    for (; i < oprsz; i += sizeof(uint16_t)) {
         *(uint16_t *)(d + i) = *(uint16_t *)(a + i) - *(uint16_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -148,9 +149,9 @@ void HELPER(gvec_sub16)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_sub32)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_SUB32, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
+    for (; i < oprsz; i += sizeof(uint32_t)) {
         *(uint32_t *)(d + i) = *(uint32_t *)(a + i) - *(uint32_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -159,9 +160,9 @@ void HELPER(gvec_sub32)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_sub64)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_SUB64, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) - *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -453,9 +454,9 @@ void HELPER(gvec_not)(void *d, void *a, uint32_t desc)
 void HELPER(gvec_and)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_AND, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) & *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -464,9 +465,9 @@ void HELPER(gvec_and)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_or)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_OR, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) | *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -475,9 +476,9 @@ void HELPER(gvec_or)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_xor)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_XOR, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) ^ *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -486,9 +487,9 @@ void HELPER(gvec_xor)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_andc)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = gvec_accel(GVEC_ACCEL_ANDC, d, a, b, oprsz);
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) &~ *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -16,6 +16,7 @@
 #include "tcg/tcg.h"
 #include "internal-common.h"
 #include "tb-context.h"
+#include "tb-jmp-cache.h"
 #include <math.h>
 
 static void dump_drift_info(GString *buf)
@@ -43,9 +44,26 @@ static void dump_accel_info(AccelState *accel, GString *buf)
                                                     "one-insn-per-tb",
                                                     &error_fatal);
 
+    bool superblocks = object_property_get_bool(OBJECT(accel),
+                                                "superblocks", &error_fatal);
+
+    bool prefetch = object_property_get_bool(OBJECT(accel),
+                                             "prefetch", &error_fatal);
+
+    bool jmp_cache_grow = object_property_get_bool(OBJECT(accel),
+                                                   "jmp-cache-grow",
+                                                   &error_fatal);
+
     g_string_append_printf(buf, "Accelerator settings:\n");
-    g_string_append_printf(buf, "one-insn-per-tb: %s\n\n",
+    g_string_append_printf(buf, "one-insn-per-tb: %s\n",
                            one_insn_per_tb ? "on" : "off");
+    g_string_append_printf(buf, "superblocks: %s\n",
+                           superblocks ? "on" : "off");
+    g_string_append_printf(buf, "prefetch: %s\n",
+                           prefetch ? "on" : "off");
+    g_string_append_printf(buf, "jmp-cache-bits: %u\n", tcg_jmp_cache_bits);
+    g_string_append_printf(buf, "jmp-cache-grow: %s\n\n",
+                           jmp_cache_grow ? "on" : "off");
 }
 
 static void print_qht_statistics(struct qht_stats hst, GString *buf)
@@ -132,34 +150,104 @@ static gboolean tb_tree_stats_iter(gpointer key, gpointer value, gpointer data)
     return false;
 }
 
-static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
+static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide,
+                             size_t *plarge)
 {
     CPUState *cpu;
-    size_t full = 0, part = 0, elide = 0;
+    size_t full = 0, part = 0, elide = 0, large = 0;
 
     CPU_FOREACH(cpu) {
         full += qatomic_read(&cpu->neg.tlb.c.full_flush_count);
         part += qatomic_read(&cpu->neg.tlb.c.part_flush_count);
         elide += qatomic_read(&cpu->neg.tlb.c.elide_flush_count);
+        large += qatomic_read(&cpu->neg.tlb.c.large_fill_count);
     }
     *pfull = full;
     *ppart = part;
     *pelide = elide;
+    *plarge = large;
 }
 
 static void tcg_dump_flush_info(GString *buf)
 {
-    size_t flush_full, flush_part, flush_elide;
+    size_t flush_full, flush_part, flush_elide, large_fill;
 
     g_string_append_printf(buf, "TB flush count      %u\n",
                            qatomic_read(&tb_ctx.tb_flush_count));
     g_string_append_printf(buf, "TB invalidate count %u\n",
                            qatomic_read(&tb_ctx.tb_phys_invalidate_count));
+    g_string_append_printf(buf, "TB code page writes %" PRIu64
+                           " (no code hit=%" PRIu64 ")\n",
+                           stat64_get(&tb_ctx.tb_smc_write_count),
+                           stat64_get(&tb_ctx.tb_smc_skip_count));
 
-    tlb_flush_counts(&flush_full, &flush_part, &flush_elide);
+    tlb_flush_counts(&flush_full, &flush_part, &flush_elide, &large_fill);
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
+    g_string_append_printf(buf, "TLB large-page fills %zu\n", large_fill);
+}
+
+/*
+ * Successors translated while a vCPU was idle.  Aborted runs hit a fault
+ * or a full code buffer and dropped the rest of the queue.
+ */
+static void tcg_dump_prefetch_info(GString *buf)
+{
+    g_string_append_printf(buf, "TB prefetch count   %" PRIu64
+                           " (aborted=%" PRIu64 ")\n",
+                           stat64_get(&tb_ctx.tb_prefetch_count),
+                           stat64_get(&tb_ctx.tb_prefetch_abort_count));
+}
+
+/*
+ * Host code spent moving guest state between host registers and env or
+ * the stack frame, as opposed to computing.
+ */
+static void tcg_dump_reg_alloc_info(GString *buf)
+{
+    size_t stores, spills, reloads;
+
+    tcg_reg_alloc_stats(&stores, &spills, &reloads);
+    g_string_append_printf(buf, "Reg alloc stores    %zu (spills=%zu)\n",
+                           stores, spills);
+    g_string_append_printf(buf, "Reg alloc reloads   %zu\n", reloads);
+}
+
+/*
+ * Misses only count lookups that the htable could satisfy, i.e. those
+ * a larger jump cache might have turned into hits.
+ */
+static void tcg_dump_jmp_cache_info(GString *buf)
+{
+    CPUState *cpu;
+    size_t hits = 0, misses = 0;
+    unsigned min_bits = UINT_MAX, max_bits = 0;
+
+    RCU_READ_LOCK_GUARD();
+    CPU_FOREACH(cpu) {
+        CPUJumpCache *jc = qatomic_rcu_read(&cpu->tb_jmp_cache);
+
+        if (!jc) {
+            continue;
+        }
+        hits += qatomic_read(&jc->hits);
+        misses += qatomic_read(&jc->misses);
+        min_bits = MIN(min_bits, jc->bits);
+        max_bits = MAX(max_bits, jc->bits);
+    }
+    if (min_bits > max_bits) {
+        return;
+    }
+
+    g_string_append_printf(buf, "TB jmp cache bits   %u", min_bits);
+    if (max_bits != min_bits) {
+        g_string_append_printf(buf, "-%u", max_bits);
+    }
+    g_string_append_printf(buf, "\n");
+    g_string_append_printf(buf, "TB jmp cache hits   %zu (%zu%%)\n", hits,
+                           hits + misses ? hits * 100 / (hits + misses) : 0);
+    g_string_append_printf(buf, "TB jmp cache misses %zu\n", misses);
 }
 
 static void dump_exec_info(GString *buf)
@@ -203,6 +291,9 @@ static void dump_exec_info(GString *buf)
     qht_statistics_destroy(&hst);
 
     g_string_append_printf(buf, "\nStatistics:\n");
+    tcg_dump_prefetch_info(buf);
+    tcg_dump_jmp_cache_info(buf);
+    tcg_dump_reg_alloc_info(buf);
     tcg_dump_flush_info(buf);
 }
 
@@ -116,7 +116,15 @@ bool translator_use_goto_tb(DisasContextBase *db, vaddr dest)
     }
 
     /* Check for the dest on the same page as the start of the TB.  */
-    return translator_is_same_page(db, dest);
+    if (!translator_is_same_page(db, dest)) {
+        return false;
+    }
+
+    /* Plugins would see translations the guest never asked for. */
+    if (qatomic_read(&tcg_prefetch) && !db->plugin_enabled) {
+        tb_prefetch_note(db->tb, dest);
+    }
+    return true;
 }
 
 void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
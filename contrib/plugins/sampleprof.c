@@ -0,0 +1,245 @@
+/*
+ * Sampling profiler
+ *
+ * Periodically samples the guest pc of every vCPU, optionally walking
+ * the guest stack through its frame pointers, without instrumenting
+ * instructions. The samples are written in the folded format of
+ * flamegraph.pl:
+ *
+ *   mmu0;0x400a10;0x400b2c;0x401230 1234
+ *
+ * where the first frame is the MMU index the vCPU ran with, followed by
+ * the return addresses from the outermost frame and the sampled pc.
+ *
+ * License: GNU GPL, version 2 or later.
+ *   See the COPYING file in the top-level directory.
+ */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <qemu-plugin.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+/*
+ * Frame record layout of the usual frame pointer ABIs: the caller's
+ * frame pointer and the return address are saved next to each other,
+ * at fixed offsets from the frame pointer.
+ */
+typedef struct {
+    const char *name;
+    const char *fp;
+    int prev_fp;
+    int ret;
+} FrameLayout;
+
+static const FrameLayout layouts[] = {
+    { "aarch64", "x29", 0, 8 },
+    { "riscv64", "fp", -16, -8 },
+    { "x86_64", "rbp", 0, 8 },
+};
+
+typedef struct {
+    struct qemu_plugin_register *fp;
+    GByteArray *buf;
+} CPU;
+
+static struct qemu_plugin_scoreboard *cpus;
+static const FrameLayout *layout;
+static unsigned int depth = 32;
+
+static GMutex lock;
+static GHashTable *stacks;
+static char *outfile;
+
+static bool read_u64(uint64_t addr, GByteArray *buf, uint64_t *val)
+{
+    g_byte_array_set_size(buf, 0);
+    if (!qemu_plugin_read_memory_vaddr(addr, buf, sizeof(*val))) {
+        return false;
+    }
+    memcpy(val, buf->data, sizeof(*val));
+    return true;
+}
+
+/* Returns the return addresses of up to @depth frames, innermost first. */
+static GArray *walk_stack(CPU *cpu)
+{
+    GArray *frames = g_array_new(FALSE, FALSE, sizeof(uint64_t));
+    uint64_t fp, ret;
+
+    if (!cpu->fp) {
+        return frames;
+    }
+
+    g_byte_array_set_size(cpu->buf, 0);
+    if (qemu_plugin_read_register(cpu->fp, cpu->buf) != sizeof(fp)) {
+        return frames;
+    }
+    memcpy(&fp, cpu->buf->data, sizeof(fp));
+
+    while (frames->len < depth && fp && !(fp & 7)) {
+        uint64_t prev;
+
+        if (!read_u64(fp + layout->ret, cpu->buf, &ret) ||
+            !read_u64(fp + layout->prev_fp, cpu->buf, &prev) || !ret) {
+            break;
+        }
+        g_array_append_val(frames, ret);
+        /* the stack grows down, so callers have higher frame pointers */
+        if (prev <= fp) {
+            break;
+        }
+        fp = prev;
+    }
+    return frames;
+}
+
+static void vcpu_sample(qemu_plugin_id_t id, const qemu_plugin_sample *sample,
+                        void *udata)
+{
+    CPU *cpu = qemu_plugin_scoreboard_find(cpus, sample->vcpu_index);
+    g_autoptr(GArray) frames = walk_stack(cpu);
+    GString *stack = g_string_new(NULL);
+    uint64_t *count;
+
+    g_string_printf(stack, "mmu%d", sample->mmu_idx);
+    for (int i = frames->len - 1; i >= 0; i--) {
+        g_string_append_printf(stack, ";0x%" PRIx64,
+                               g_array_index(frames, uint64_t, i));
+    }
+    g_string_append_printf(stack, ";0x%" PRIx64, sample->pc);
+
+    g_mutex_lock(&lock);
+    count = g_hash_table_lookup(stacks, stack->str);
+    if (count) {
+        (*count)++;
+        g_string_free(stack, TRUE);
+    } else {
+        count = g_new(uint64_t, 1);
+        *count = 1;
+        g_hash_table_insert(stacks, g_string_free(stack, FALSE), count);
+    }
+    g_mutex_unlock(&lock);
+}
+
+static void vcpu_init(qemu_plugin_id_t id, unsigned int vcpu_index)
+{
+    CPU *cpu = qemu_plugin_scoreboard_find(cpus, vcpu_index);
+
+    cpu->buf = g_byte_array_new();
+    if (layout) {
+        g_autoptr(GArray) regs = qemu_plugin_get_registers();
+
+        for (int i = 0; i < regs->len; i++) {
+            qemu_plugin_reg_descriptor *rd =
+                &g_array_index(regs, qemu_plugin_reg_descriptor, i);
+
+            if (g_str_equal(rd->name, layout->fp)) {
+                cpu->fp = rd->handle;
+            }
+        }
+        if (!cpu->fp) {
+            fprintf(stderr, "sampleprof: no %s register, "
+                    "not walking the stack\n", layout->fp);
+        }
+    }
+}
+
+static void plugin_exit(qemu_plugin_id_t id, void *p)
+{
+    g_autoptr(GString) report = g_string_new(NULL);
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_mutex_lock(&lock);
+    g_hash_table_iter_init(&iter, stacks);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        g_string_append_printf(report, "%s %" PRIu64 "\n",
+                               (char *)key, *(uint64_t *)value);
+    }
+    g_mutex_unlock(&lock);
+
+    if (outfile) {
+        g_autoptr(GError) err = NULL;
+
+        if (!g_file_set_contents(outfile, report->str, report->len, &err)) {
+            fprintf(stderr, "sampleprof: %s\n", err->message);
+        }
+    } else {
+        qemu_plugin_outs(report->str);
+    }
+
+    for (int i = 0; i < qemu_plugin_num_vcpus(); i++) {
+        CPU *cpu = qemu_plugin_scoreboard_find(cpus, i);
+
+        if (cpu->buf) {
+            g_byte_array_free(cpu->buf, TRUE);
+        }
+    }
+    qemu_plugin_scoreboard_free(cpus);
+    g_hash_table_destroy(stacks);
+    g_free(outfile);
+}
+
+QEMU_PLUGIN_EXPORT
+int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
+                        int argc, char **argv)
+{
+    enum qemu_plugin_sample_trigger trigger = QEMU_PLUGIN_SAMPLE_HOST_TIME;
+    uint64_t period = 1000000;
+
+    for (int i = 0; i < argc; i++) {
+        char *opt = argv[i];
+        g_auto(GStrv) tokens = g_strsplit(opt, "=", 2);
+
+        if (g_strcmp0(tokens[0], "freq") == 0) {
+            uint64_t freq = g_ascii_strtoull(tokens[1], NULL, 10);
+
+            if (!freq || freq > 1000) {
+                fprintf(stderr, "freq must be between 1 and 1000 Hz: %s\n",
+                        opt);
+                return -1;
+            }
+            trigger = QEMU_PLUGIN_SAMPLE_HOST_TIME;
+            period = 1000000000 / freq;
+        } else if (g_strcmp0(tokens[0], "insns") == 0) {
+            period = g_ascii_strtoull(tokens[1], NULL, 10);
+            if (!period) {
+                fprintf(stderr, "insns must be positive: %s\n", opt);
+                return -1;
+            }
+            trigger = QEMU_PLUGIN_SAMPLE_INSNS;
+        } else if (g_strcmp0(tokens[0], "stack") == 0) {
+            layout = NULL;
+            for (int j = 0; j < G_N_ELEMENTS(layouts); j++) {
+                if (g_strcmp0(tokens[1], layouts[j].name) == 0) {
+                    layout = &layouts[j];
+                }
+            }
+            if (!layout) {
+                fprintf(stderr, "unsupported stack layout: %s\n", opt);
+                return -1;
+            }
+        } else if (g_strcmp0(tokens[0], "depth") == 0) {
+            depth = g_ascii_strtoull(tokens[1], NULL, 10);
+        } else if (g_strcmp0(tokens[0], "outfile") == 0) {
+            outfile = g_strdup(tokens[1]);
+        } else {
+            fprintf(stderr, "option parsing failed: %s\n", opt);
+            return -1;
+        }
+    }
+
+    cpus = qemu_plugin_scoreboard_new(sizeof(CPU));
+    stacks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    qemu_plugin_register_vcpu_init_cb(id, vcpu_init);
+    qemu_plugin_register_vcpu_sample_cb(id, trigger, period, vcpu_sample,
+                                        NULL);
+    qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+    return 0;
+}
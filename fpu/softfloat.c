@@ -236,6 +236,22 @@ static inline bool can_use_fpu(const float_status *s)
                   s->float_rounding_mode == float_round_nearest_even);
 }
 
+/*
+ * Integers of up to @bits significant bits convert to floating point
+ * exactly, so the host conversion is usable whatever the rounding mode
+ * and exception flags.
+ */
+static inline bool hard_int_is_exact(int64_t a, int bits)
+{
+    return !QEMU_NO_HARDFLOAT &&
+           a >= -(INT64_C(1) << bits) && a <= (INT64_C(1) << bits);
+}
+
+static inline bool hard_uint_is_exact(uint64_t a, int bits)
+{
+    return !QEMU_NO_HARDFLOAT && a <= (UINT64_C(1) << bits);
+}
+
 /*
  * Hardfloat generation functions. Each operation can have two flavors:
  * either using softfloat primitives (e.g. float32_is_zero_or_normal) for
@@ -2422,7 +2438,7 @@ float64_muladd(float64 xa, float64 xb, float64 xc, int flags, float_status *s)
 
         if (unlikely(f64_is_inf(ur))) {
             float_raise(float_flag_overflow, s);
-        } else if (unlikely(fabs(ur.h) <= FLT_MIN)) {
+        } else if (unlikely(fabs(ur.h) <= DBL_MIN)) {
             ua = ua_orig;
             uc = uc_orig;
             goto soft;
@@ -3119,6 +3135,41 @@ floatx80 floatx80_round_to_int(floatx80 a, float_status *status)
  * Floating-point to signed integer conversions
  */
 
+/*
+ * Hardfloat float to int conversion. Zero or normal inputs in range of
+ * the result convert with at most the fraction lost, which we detect by
+ * converting back; inexact is the only flag that can be raised, so
+ * unlike the arithmetic ops there is no need for it to be already set.
+ * The host rounds to nearest even, so any other rounding mode, as well
+ * as fixed-point scaling, is left to softfloat.  @max is exclusive and
+ * chosen so that rounding up cannot overflow.
+ */
+static inline bool hard_f64_to_sint(double d, FloatRoundMode rmode, int scale,
+                                    double min, double max, int64_t *ret,
+                                    float_status *s)
+{
+    int64_t r;
+
+    if (QEMU_NO_HARDFLOAT || scale != 0 || !(d >= min && d < max)) {
+        return false;
+    }
+    switch (rmode) {
+    case float_round_nearest_even:
+        r = llrint(d);
+        break;
+    case float_round_to_zero:
+        r = (int64_t)d;
+        break;
+    default:
+        return false;
+    }
+    if ((double)r != d) {
+        float_raise(float_flag_inexact, s);
+    }
+    *ret = r;
+    return true;
+}
+
 int8_t float16_to_int8_scalbn(float16 a, FloatRoundMode rmode, int scale,
                               float_status *s)
 {
@@ -3168,6 +3219,14 @@ int32_t float32_to_int32_scalbn(float32 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    union_float32 ua;
+    int64_t r;
+
+    ua.s = a;
+    if (float32_is_zero_or_normal(a) &&
+        hard_f64_to_sint(ua.h, rmode, scale, -0x1p31, 0x1p31 - 0.5, &r, s)) {
+        return r;
+    }
 
     float32_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT32_MIN, INT32_MAX, s);
@@ -3177,6 +3236,14 @@ int64_t float32_to_int64_scalbn(float32 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    union_float32 ua;
+    int64_t r;
+
+    ua.s = a;
+    if (float32_is_zero_or_normal(a) &&
+        hard_f64_to_sint(ua.h, rmode, scale, -0x1p63, 0x1p63, &r, s)) {
+        return r;
+    }
 
     float32_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT64_MIN, INT64_MAX, s);
@@ -3195,6 +3262,14 @@ int32_t float64_to_int32_scalbn(float64 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    union_float64 ua;
+    int64_t r;
+
+    ua.s = a;
+    if (float64_is_zero_or_normal(a) &&
+        hard_f64_to_sint(ua.h, rmode, scale, -0x1p31, 0x1p31 - 0.5, &r, s)) {
+        return r;
+    }
 
     float64_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT32_MIN, INT32_MAX, s);
@@ -3204,6 +3279,14 @@ int64_t float64_to_int64_scalbn(float64 a, FloatRoundMode rmode, int scale,
                                 float_status *s)
 {
     FloatParts64 p;
+    union_float64 ua;
+    int64_t r;
+
+    ua.s = a;
+    if (float64_is_zero_or_normal(a) &&
+        hard_f64_to_sint(ua.h, rmode, scale, -0x1p63, 0x1p63, &r, s)) {
+        return r;
+    }
 
     float64_unpack_canonical(&p, a, s);
     return parts_float_to_sint(&p, rmode, scale, INT64_MIN, INT64_MAX, s);
@@ -3959,7 +4042,8 @@ float32 int64_to_float32_scalbn(int64_t a, int scale, float_status *status)
     FloatParts64 p;
 
     /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    if (likely(scale == 0) &&
+        (hard_int_is_exact(a, 24) || can_use_fpu(status))) {
         union_float32 ur;
         ur.h = a;
         return ur.s;
@@ -3999,7 +4083,8 @@ float64 int64_to_float64_scalbn(int64_t a, int scale, float_status *status)
     FloatParts64 p;
 
     /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    if (likely(scale == 0) &&
+        (hard_int_is_exact(a, 53) || can_use_fpu(status))) {
         union_float64 ur;
         ur.h = a;
         return ur.s;
@@ -4179,7 +4264,8 @@ float32 uint64_to_float32_scalbn(uint64_t a, int scale, float_status *status)
     FloatParts64 p;
 
     /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    if (likely(scale == 0) &&
+        (hard_uint_is_exact(a, 24) || can_use_fpu(status))) {
         union_float32 ur;
         ur.h = a;
         return ur.s;
@@ -4219,7 +4305,8 @@ float64 uint64_to_float64_scalbn(uint64_t a, int scale, float_status *status)
     FloatParts64 p;
 
     /* Without scaling, there are no overflow concerns. */
-    if (likely(scale == 0) && can_use_fpu(status)) {
+    if (likely(scale == 0) &&
+        (hard_uint_is_exact(a, 53) || can_use_fpu(status))) {
         union_float64 ur;
         ur.h = a;
         return ur.s;
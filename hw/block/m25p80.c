@@ -30,6 +30,7 @@
 #include "hw/qdev-properties-system.h"
 #include "hw/ssi/ssi.h"
 #include "migration/vmstate.h"
+#include "system/memory.h"
 #include "qemu/bitops.h"
 #include "qemu/log.h"
 #include "qemu/module.h"
@@ -524,6 +525,9 @@ struct Flash {
 
     const FlashPartInfo *pi;
 
+    /* Memory-mapped, read-only view of the storage, see m25p80_get_xip() */
+    bool xip;
+    MemoryRegion xip_mr;
 };
 
 struct M25P80Class {
@@ -597,6 +601,14 @@ static inline void flash_sync_area(Flash *s, int64_t off, int64_t len)
     blk_aio_pwritev(s->blk, off, iov, 0, blk_sync_complete, iov);
 }
 
+/* Invalidate code translated from the XIP view of a changed range */
+static void flash_storage_changed(Flash *s, uint32_t offset, uint32_t len)
+{
+    if (s->xip) {
+        memory_region_flush_rom_device(&s->xip_mr, offset, len);
+    }
+}
+
 static void flash_erase(Flash *s, int offset, FlashCMD cmd)
 {
     uint32_t len;
@@ -646,6 +658,7 @@ static void flash_erase(Flash *s, int offset, FlashCMD cmd)
         return;
     }
     memset(s->storage + offset, 0xff, len);
+    flash_storage_changed(s, offset, len);
     flash_sync_area(s, offset, len);
 }
 
@@ -701,6 +714,7 @@ void flash_write8(Flash *s, uint32_t addr, uint8_t data)
     } else {
         s->storage[s->cur_addr] &= data;
     }
+    flash_storage_changed(s, s->cur_addr, 1);
 
     flash_sync_dirty(s, page);
     s->dirty_page = page;
@@ -1662,6 +1676,46 @@ static void m25p80_write_protect_pin_irq_handler(void *opaque, int n, int level)
     s->wp_level = !!level;
 }
 
+/*
+ * The XIP view is a ROM device whose RAM is the storage itself, so reads
+ * through it are served from the same bytes the SPI commands access.
+ * The contents come from the drive, so the RAM is not migrated.
+ */
+static uint64_t m25p80_xip_read(void *opaque, hwaddr addr, unsigned size)
+{
+    Flash *s = opaque;
+
+    return ldn_le_p(s->storage + addr, size);
+}
+
+static void m25p80_xip_write(void *opaque, hwaddr addr, uint64_t val,
+                             unsigned size)
+{
+    qemu_log_mask(LOG_GUEST_ERROR,
+                  "M25P80: write to read-only XIP view at 0x%" HWADDR_PRIx
+                  "\n", addr);
+}
+
+static const MemoryRegionOps m25p80_xip_ops = {
+    .read = m25p80_xip_read,
+    .write = m25p80_xip_write,
+    .endianness = DEVICE_LITTLE_ENDIAN,
+};
+
+static uint8_t *m25p80_alloc_storage(Flash *s, Error **errp)
+{
+    if (!s->xip) {
+        return blk_blockalign(s->blk, s->size);
+    }
+    if (!memory_region_init_rom_device_nomigrate(&s->xip_mr, OBJECT(s),
+                                                 &m25p80_xip_ops, s,
+                                                 "m25p80.xip", s->size,
+                                                 errp)) {
+        return NULL;
+    }
+    return memory_region_get_ram_ptr(&s->xip_mr);
+}
+
 static void m25p80_realize(SSIPeripheral *ss, Error **errp)
 {
     Flash *s = M25P80(ss);
@@ -1682,7 +1736,10 @@ static void m25p80_realize(SSIPeripheral *ss, Error **errp)
         }
 
         trace_m25p80_binding(s);
-        s->storage = blk_blockalign(s->blk, s->size);
+        s->storage = m25p80_alloc_storage(s, errp);
+        if (!s->storage) {
+            return;
+        }
 
         if (!blk_check_size_and_read_all(s->blk, DEVICE(s),
                                          s->storage, s->size, errp)) {
@@ -1690,7 +1747,10 @@ static void m25p80_realize(SSIPeripheral *ss, Error **errp)
         }
     } else {
         trace_m25p80_binding_no_bdrv(s);
-        s->storage = blk_blockalign(NULL, s->size);
+        s->storage = m25p80_alloc_storage(s, errp);
+        if (!s->storage) {
+            return;
+        }
         memset(s->storage, 0xFF, s->size);
     }
 
@@ -1729,6 +1789,7 @@ static const Property m25p80_properties[] = {
     DEFINE_PROP_UINT8("spansion-cr3nv", Flash, spansion_cr3nv, 0x2),
     DEFINE_PROP_UINT8("spansion-cr4nv", Flash, spansion_cr4nv, 0x10),
     DEFINE_PROP_DRIVE("drive", Flash, blk),
+    DEFINE_PROP_BOOL("xip", Flash, xip, false),
 };
 
 static int m25p80_pre_load(void *opaque)
@@ -1905,3 +1966,10 @@ BlockBackend *m25p80_get_blk(DeviceState *dev)
 {
     return M25P80(dev)->blk;
 }
+
+MemoryRegion *m25p80_get_xip(DeviceState *dev)
+{
+    Flash *s = M25P80(dev);
+
+    return s->xip ? &s->xip_mr : NULL;
+}
@@ -23,6 +23,7 @@
  */
 #include "qemu/osdep.h"
 #include "qemu/main-loop.h"
+#include "qemu/bitops.h"
 #include "hw/irq.h"
 #include "qom/object.h"
 
@@ -34,6 +35,24 @@ void qemu_set_irq(qemu_irq irq, int level)
     irq->handler(irq->opaque, irq->n, level);
 }
 
+uint64_t qemu_set_irq_group(qemu_irq *irqs, int n, uint64_t cur,
+                            uint64_t levels, uint64_t force)
+{
+    uint64_t mask, todo;
+
+    assert(n >= 0 && n <= 64);
+    mask = n ? MAKE_64BIT_MASK(0, n) : 0;
+    todo = ((cur ^ levels) | force) & mask;
+
+    while (todo) {
+        int i = ctz64(todo);
+
+        qemu_set_irq(irqs[i], (levels >> i) & 1);
+        todo &= todo - 1;
+    }
+    return levels & mask;
+}
+
 static void init_irq_fields(IRQState *irq, qemu_irq_handler handler,
                             void *opaque, int n)
 {
@@ -72,6 +72,7 @@ void riscv_boot_info_init(RISCVBootInfo *info, RISCVHartArrayState *harts)
     info->kernel_size = 0;
     info->initrd_size = 0;
     info->is_32bit = riscv_is_32bit(harts);
+    info->elf_in_ram = false;
 }
 
 target_ulong riscv_calc_kernel_start_addr(RISCVBootInfo *info,
@@ -247,7 +248,7 @@ void riscv_load_kernel(MachineState *machine,
     kernel_size = load_elf_ram_sym(kernel_filename, NULL, NULL, NULL, NULL,
                                    &info->image_low_addr, &info->image_high_addr,
                                    NULL, ELFDATA2LSB, EM_RISCV,
-                                   1, 0, NULL, true, sym_cb);
+                                   1, 0, NULL, !info->elf_in_ram, sym_cb);
     if (kernel_size > 0) {
         info->kernel_size = kernel_size;
         goto out;
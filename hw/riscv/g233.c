@@ -21,6 +21,7 @@
 #include "qemu/osdep.h"
 #include "qemu/cutils.h"
 #include "qemu/error-report.h"
+#include "qemu/log.h"
 #include "qapi/error.h"
 #include "system/system.h"
 #include "system/memory.h"
@@ -30,11 +31,15 @@
 #include "hw/sysbus.h"
 #include "hw/riscv/g233.h"
 #include "hw/riscv/boot.h"
+#include "hw/riscv/numa.h"
 #include "hw/intc/riscv_aclint.h"
 #include "hw/intc/sifive_plic.h"
 #include "hw/misc/unimp.h"
 #include "hw/char/pl011.h"
+#include "hw/block/flash.h"
 #include "system/block-backend.h"
+#include "system/reset.h"
+#include "system/device_tree.h"
 
 /* TODO: you need include some header files */
 
@@ -46,6 +51,7 @@ static const MemMapEntry g233_memmap[] = {
     [G233_DEV_GPIO0] =    { 0x10012000,     0x1000 },
     [G233_DEV_PWM0] =     { 0x10015000,     0x1000 },
     [G233_DEV_SPI0] =     { 0x10018000,     0x1000 },
+    [G233_DEV_XIP] =      { 0x20000000,  0x1000000 },
     [G233_DEV_DRAM] =     { 0x80000000, 0x40000000 },
 };
 
@@ -57,28 +63,59 @@ static void g233_soc_init(Object *obj)
      */
     MachineState *ms = MACHINE(qdev_get_machine());
     G233SoCState *s = RISCV_G233_SOC(obj);
-    
-    /* Initialize CPUs */
-    object_initialize_child(obj, "cpus", &s->cpus, TYPE_RISCV_HART_ARRAY);
-    object_property_set_int(OBJECT(&s->cpus), "num-harts", ms->smp.cpus, &error_abort);
-    object_property_set_int(OBJECT(&s->cpus), "resetvec", 0x1004, &error_abort);
-    object_property_set_str(OBJECT(&s->cpus), "cpu-type", ms->cpu_type, &error_abort);
+    int i;
+
+    /* Initialize CPUs, one hart array per socket */
+    s->num_sockets = riscv_socket_count(ms);
+    for (i = 0; i < s->num_sockets; i++) {
+        g_autofree char *name = g_strdup_printf("cpus%d", i);
+        RISCVHartArrayState *cpus = &s->cpus[i];
+
+        object_initialize_child(obj, name, cpus, TYPE_RISCV_HART_ARRAY);
+        object_property_set_int(OBJECT(cpus), "hartid-base",
+                                riscv_socket_first_hartid(ms, i),
+                                &error_abort);
+        object_property_set_int(OBJECT(cpus), "num-harts",
+                                riscv_socket_hart_count(ms, i), &error_abort);
+        object_property_set_int(OBJECT(cpus), "resetvec", 0x1004,
+                                &error_abort);
+        object_property_set_str(OBJECT(cpus), "cpu-type", ms->cpu_type,
+                                &error_abort);
+    }
     //配置cpu的属性
     object_initialize_child(obj, "gpio", &s->gpio, TYPE_SIFIVE_GPIO);
     object_initialize_child(obj, "spi", &s->spi, TYPE_G233_SPI);
 
 }
 
+/* Every hart gets its own M-mode and S-mode PLIC contexts */
+static char *g233_plic_hart_config(int hart_count)
+{
+    g_autofree const char **vals = g_new(const char *, hart_count + 1);
+    int i;
+
+    for (i = 0; i < hart_count; i++) {
+        vals[i] = G233_PLIC_HART_CONFIG;
+    }
+    vals[i] = NULL;
+
+    /* g_strjoinv() obliges us to cast away const here */
+    return g_strjoinv(",", (char **)vals);
+}
+
 static void g233_soc_realize(DeviceState *dev, Error **errp)
 {
     MachineState *ms = MACHINE(qdev_get_machine());
     G233SoCState *s = RISCV_G233_SOC(dev);
     MemoryRegion *sys_mem = get_system_memory();
     const MemMapEntry *memmap = g233_memmap;
+    g_autofree char *plic_hart_config = NULL;
+    int i;
 
     /* CPUs realize */
-
-    sysbus_realize(SYS_BUS_DEVICE(&s->cpus), &error_fatal);//注册cpu
+    for (i = 0; i < s->num_sockets; i++) {
+        sysbus_realize(SYS_BUS_DEVICE(&s->cpus[i]), &error_fatal);//注册cpu
+    }
 
 
     /* Mask ROM */
@@ -87,9 +124,10 @@ static void g233_soc_realize(DeviceState *dev, Error **errp)
     memory_region_add_subregion(sys_mem, memmap[G233_DEV_MROM].base,
                                 &s->mask_rom);
 
-    /* MMIO */
+    /* MMIO: a single PLIC and CLINT shared by all harts of all sockets */
+    plic_hart_config = g233_plic_hart_config(ms->smp.cpus);
     s->plic = sifive_plic_create(memmap[G233_DEV_PLIC].base,
-                                 (char *)G233_PLIC_HART_CONFIG, ms->smp.cpus, 0,
+                                 plic_hart_config, ms->smp.cpus, 0,
                                  G233_PLIC_NUM_SOURCES,
                                  G233_PLIC_NUM_PRIORITIES,
                                  G233_PLIC_PRIORITY_BASE,
@@ -107,7 +145,7 @@ static void g233_soc_realize(DeviceState *dev, Error **errp)
                                0, ms->smp.cpus,
                                RISCV_ACLINT_DEFAULT_MTIMECMP,
                                RISCV_ACLINT_DEFAULT_MTIME,
-                               32768, false); /* TODO: set default freq */
+                               G233_CLINT_TIMEBASE_FREQ, false);
 
     /* GPIO */
     if (!sysbus_realize(SYS_BUS_DEVICE(&s->gpio), errp)) {
@@ -121,6 +159,9 @@ static void g233_soc_realize(DeviceState *dev, Error **errp)
     qdev_pass_gpios(DEVICE(&s->gpio), dev, NULL);
 
 //添加spi设备
+    /* Fast-read DMA from the SPI flashes lands in system memory */
+    object_property_set_link(OBJECT(&s->spi), "dma", OBJECT(sys_mem),
+                             &error_abort);
     if (!sysbus_realize(SYS_BUS_DEVICE(&s->spi), errp)) {
         return;
     }
@@ -129,7 +170,7 @@ static void g233_soc_realize(DeviceState *dev, Error **errp)
     sysbus_connect_irq(SYS_BUS_DEVICE(&s->spi), 0,
                        qdev_get_gpio_in(DEVICE(s->plic), G233_SPI_IRQ));
     /* Connect GPIO interrupts to the PLIC */
-    for (int i = 0; i < 32; i++) {
+    for (i = 0; i < 32; i++) {
         sysbus_connect_irq(SYS_BUS_DEVICE(&s->gpio), i,
                            qdev_get_gpio_in(DEVICE(s->plic),
                                             G233_GPIO0_IRQ0 + i));
@@ -169,6 +210,332 @@ static void g233_soc_register_types(void)
 
 type_init(g233_soc_register_types)
 
+/*
+ * Execute-in-place window onto the SPI flash on chip-select 0.  The
+ * flash's own storage is mapped at the start of the window as a ROM
+ * device, so reads (and TCG instruction fetches) are served straight
+ * from it, writes are rejected, and program or erase commands sent
+ * through the SPI controller are visible at once.
+ */
+static void g233_xip_init(G233MachineState *s, DeviceState *flash)
+{
+    const MemMapEntry *memmap = g233_memmap;
+
+    memory_region_init(&s->xip, OBJECT(s), "riscv.g233.xip",
+                       memmap[G233_DEV_XIP].size);
+    memory_region_add_subregion(&s->xip, 0, m25p80_get_xip(flash));
+    memory_region_add_subregion(get_system_memory(), memmap[G233_DEV_XIP].base,
+                                &s->xip);
+}
+
+static void g233_create_fdt_cpus(G233MachineState *s, uint32_t *phandle,
+                                 uint32_t *intc_phandles)
+{
+    MachineState *ms = MACHINE(s);
+    void *fdt = ms->fdt;
+    int socket, i;
+
+    qemu_fdt_add_subnode(fdt, "/cpus");
+    qemu_fdt_setprop_cell(fdt, "/cpus", "timebase-frequency",
+                          G233_CLINT_TIMEBASE_FREQ);
+    qemu_fdt_setprop_cell(fdt, "/cpus", "#size-cells", 0x0);
+    qemu_fdt_setprop_cell(fdt, "/cpus", "#address-cells", 0x1);
+
+    for (socket = 0; socket < s->soc.num_sockets; socket++) {
+        RISCVHartArrayState *harts = &s->soc.cpus[socket];
+
+        for (i = 0; i < harts->num_harts; i++) {
+            int hartid = harts->hartid_base + i;
+            g_autofree char *name = g_strdup_printf("/cpus/cpu@%d", hartid);
+            g_autofree char *intc = g_strdup_printf("%s/interrupt-controller",
+                                                    name);
+
+            qemu_fdt_add_subnode(fdt, name);
+            riscv_isa_write_fdt(&harts->harts[i], fdt, name);
+            qemu_fdt_setprop_string(fdt, name, "compatible", "riscv");
+            qemu_fdt_setprop_string(fdt, name, "status", "okay");
+            qemu_fdt_setprop_cell(fdt, name, "reg", hartid);
+            qemu_fdt_setprop_string(fdt, name, "device_type", "cpu");
+            riscv_socket_fdt_write_id(ms, name, socket);
+
+            intc_phandles[hartid] = (*phandle)++;
+            qemu_fdt_add_subnode(fdt, intc);
+            qemu_fdt_setprop_cell(fdt, intc, "phandle", intc_phandles[hartid]);
+            qemu_fdt_setprop_string(fdt, intc, "compatible", "riscv,cpu-intc");
+            qemu_fdt_setprop(fdt, intc, "interrupt-controller", NULL, 0);
+            qemu_fdt_setprop_cell(fdt, intc, "#interrupt-cells", 1);
+        }
+    }
+}
+
+static void g233_create_fdt_memory(G233MachineState *s)
+{
+    MachineState *ms = MACHINE(s);
+    int socket;
+
+    for (socket = 0; socket < s->soc.num_sockets; socket++) {
+        hwaddr addr = g233_memmap[G233_DEV_DRAM].base +
+                      riscv_socket_mem_offset(ms, socket);
+        uint64_t size = riscv_socket_mem_size(ms, socket);
+        g_autofree char *name = g_strdup_printf("/memory@%" HWADDR_PRIx,
+                                                addr);
+
+        qemu_fdt_add_subnode(ms->fdt, name);
+        qemu_fdt_setprop_sized_cells(ms->fdt, name, "reg", 2, addr, 2, size);
+        qemu_fdt_setprop_string(ms->fdt, name, "device_type", "memory");
+        riscv_socket_fdt_write_id(ms, name, socket);
+    }
+    riscv_socket_fdt_write_distance_matrix(ms);
+}
+
+static void g233_create_fdt_intc(G233MachineState *s, uint32_t *phandle,
+                                 uint32_t *intc_phandles,
+                                 uint32_t *plic_phandle)
+{
+    MachineState *ms = MACHINE(s);
+    const MemMapEntry *memmap = g233_memmap;
+    void *fdt = ms->fdt;
+    int cpus = ms->smp.cpus;
+    g_autofree uint32_t *clint_cells = g_new0(uint32_t, cpus * 4);
+    g_autofree uint32_t *plic_cells = g_new0(uint32_t, cpus * 4);
+    g_autofree char *clint_name = NULL;
+    g_autofree char *plic_name = NULL;
+    static const char * const clint_compat[2] = {
+        "sifive,clint0", "riscv,clint0"
+    };
+    static const char * const plic_compat[2] = {
+        "sifive,plic-1.0.0", "riscv,plic0"
+    };
+    int cpu;
+
+    for (cpu = 0; cpu < cpus; cpu++) {
+        clint_cells[cpu * 4 + 0] = cpu_to_be32(intc_phandles[cpu]);
+        clint_cells[cpu * 4 + 1] = cpu_to_be32(IRQ_M_SOFT);
+        clint_cells[cpu * 4 + 2] = cpu_to_be32(intc_phandles[cpu]);
+        clint_cells[cpu * 4 + 3] = cpu_to_be32(IRQ_M_TIMER);
+        /* Contexts in G233_PLIC_HART_CONFIG order: M-mode, then S-mode */
+        plic_cells[cpu * 4 + 0] = cpu_to_be32(intc_phandles[cpu]);
+        plic_cells[cpu * 4 + 1] = cpu_to_be32(IRQ_M_EXT);
+        plic_cells[cpu * 4 + 2] = cpu_to_be32(intc_phandles[cpu]);
+        plic_cells[cpu * 4 + 3] = cpu_to_be32(IRQ_S_EXT);
+    }
+
+    clint_name = g_strdup_printf("/soc/clint@%" HWADDR_PRIx,
+                                 memmap[G233_DEV_CLINT].base);
+    qemu_fdt_add_subnode(fdt, clint_name);
+    qemu_fdt_setprop_string_array(fdt, clint_name, "compatible",
+                                  (char **)&clint_compat,
+                                  ARRAY_SIZE(clint_compat));
+    qemu_fdt_setprop_cells(fdt, clint_name, "reg",
+        0x0, memmap[G233_DEV_CLINT].base, 0x0, memmap[G233_DEV_CLINT].size);
+    qemu_fdt_setprop(fdt, clint_name, "interrupts-extended",
+                     clint_cells, cpus * sizeof(uint32_t) * 4);
+
+    *plic_phandle = (*phandle)++;
+    plic_name = g_strdup_printf("/soc/interrupt-controller@%" HWADDR_PRIx,
+                                memmap[G233_DEV_PLIC].base);
+    qemu_fdt_add_subnode(fdt, plic_name);
+    qemu_fdt_setprop_cell(fdt, plic_name, "#interrupt-cells", 1);
+    qemu_fdt_setprop_cell(fdt, plic_name, "#address-cells", 0);
+    qemu_fdt_setprop_string_array(fdt, plic_name, "compatible",
+                                  (char **)&plic_compat,
+                                  ARRAY_SIZE(plic_compat));
+    qemu_fdt_setprop(fdt, plic_name, "interrupt-controller", NULL, 0);
+    qemu_fdt_setprop(fdt, plic_name, "interrupts-extended",
+                     plic_cells, cpus * sizeof(uint32_t) * 4);
+    qemu_fdt_setprop_cells(fdt, plic_name, "reg",
+        0x0, memmap[G233_DEV_PLIC].base, 0x0, memmap[G233_DEV_PLIC].size);
+    qemu_fdt_setprop_cell(fdt, plic_name, "riscv,ndev",
+                          G233_PLIC_NUM_SOURCES - 1);
+    qemu_fdt_setprop_cell(fdt, plic_name, "phandle", *plic_phandle);
+}
+
+static void g233_create_fdt_peripherals(G233MachineState *s, uint32_t *phandle,
+                                        uint32_t plic_phandle)
+{
+    MachineState *ms = MACHINE(s);
+    const MemMapEntry *memmap = g233_memmap;
+    void *fdt = ms->fdt;
+    uint32_t clk_phandle = (*phandle)++;
+    g_autofree char *uart_name = NULL;
+    g_autofree char *gpio_name = NULL;
+    g_autofree char *spi_name = NULL;
+    g_autofree char *xip_name = NULL;
+    g_autofree uint32_t *gpio_irqs = g_new0(uint32_t, 32);
+    static const char * const uart_compat[2] = {
+        "arm,pl011", "arm,primecell"
+    };
+    static const char * const uart_clk_names[2] = {
+        "uartclk", "apb_pclk"
+    };
+    int i;
+
+    qemu_fdt_add_subnode(fdt, "/apb-pclk");
+    qemu_fdt_setprop_string(fdt, "/apb-pclk", "compatible", "fixed-clock");
+    qemu_fdt_setprop_cell(fdt, "/apb-pclk", "#clock-cells", 0x0);
+    qemu_fdt_setprop_cell(fdt, "/apb-pclk", "clock-frequency", 24000000);
+    qemu_fdt_setprop_string(fdt, "/apb-pclk", "clock-output-names", "clk24mhz");
+    qemu_fdt_setprop_cell(fdt, "/apb-pclk", "phandle", clk_phandle);
+
+    uart_name = g_strdup_printf("/soc/serial@%" HWADDR_PRIx,
+                                memmap[G233_DEV_UART0].base);
+    qemu_fdt_add_subnode(fdt, uart_name);
+    qemu_fdt_setprop_string_array(fdt, uart_name, "compatible",
+                                  (char **)&uart_compat,
+                                  ARRAY_SIZE(uart_compat));
+    qemu_fdt_setprop_cells(fdt, uart_name, "reg",
+        0x0, memmap[G233_DEV_UART0].base, 0x0, memmap[G233_DEV_UART0].size);
+    qemu_fdt_setprop_cell(fdt, uart_name, "interrupt-parent", plic_phandle);
+    qemu_fdt_setprop_cell(fdt, uart_name, "interrupts", G233_UART0_IRQ);
+    qemu_fdt_setprop_cells(fdt, uart_name, "clocks", clk_phandle, clk_phandle);
+    qemu_fdt_setprop_string_array(fdt, uart_name, "clock-names",
+                                  (char **)&uart_clk_names,
+                                  ARRAY_SIZE(uart_clk_names));
+
+    qemu_fdt_add_subnode(fdt, "/chosen");
+    qemu_fdt_setprop_string(fdt, "/chosen", "stdout-path", uart_name);
+
+    for (i = 0; i < 32; i++) {
+        gpio_irqs[i] = cpu_to_be32(G233_GPIO0_IRQ0 + i);
+    }
+    gpio_name = g_strdup_printf("/soc/gpio@%" HWADDR_PRIx,
+                                memmap[G233_DEV_GPIO0].base);
+    qemu_fdt_add_subnode(fdt, gpio_name);
+    qemu_fdt_setprop_string(fdt, gpio_name, "compatible", "sifive,gpio0");
+    qemu_fdt_setprop_cells(fdt, gpio_name, "reg",
+        0x0, memmap[G233_DEV_GPIO0].base, 0x0, memmap[G233_DEV_GPIO0].size);
+    qemu_fdt_setprop_cell(fdt, gpio_name, "interrupt-parent", plic_phandle);
+    qemu_fdt_setprop(fdt, gpio_name, "interrupts", gpio_irqs,
+                     32 * sizeof(uint32_t));
+    qemu_fdt_setprop_cell(fdt, gpio_name, "#interrupt-cells", 2);
+    qemu_fdt_setprop(fdt, gpio_name, "interrupt-controller", NULL, 0);
+    qemu_fdt_setprop_cell(fdt, gpio_name, "#gpio-cells", 2);
+    qemu_fdt_setprop(fdt, gpio_name, "gpio-controller", NULL, 0);
+
+    spi_name = g_strdup_printf("/soc/spi@%" HWADDR_PRIx,
+                               memmap[G233_DEV_SPI0].base);
+    qemu_fdt_add_subnode(fdt, spi_name);
+    qemu_fdt_setprop_string(fdt, spi_name, "compatible", "gevico,g233-spi");
+    qemu_fdt_setprop_cells(fdt, spi_name, "reg",
+        0x0, memmap[G233_DEV_SPI0].base, 0x0, memmap[G233_DEV_SPI0].size);
+    qemu_fdt_setprop_cell(fdt, spi_name, "interrupt-parent", plic_phandle);
+    qemu_fdt_setprop_cell(fdt, spi_name, "interrupts", G233_SPI_IRQ);
+    qemu_fdt_setprop_cell(fdt, spi_name, "#address-cells", 1);
+    qemu_fdt_setprop_cell(fdt, spi_name, "#size-cells", 0);
+
+    /* w25x16 on CS0 and w25x32 on CS1 */
+    for (i = 0; i < 2; i++) {
+        g_autofree char *flash_name = g_strdup_printf("%s/flash@%d",
+                                                      spi_name, i);
+
+        qemu_fdt_add_subnode(fdt, flash_name);
+        qemu_fdt_setprop_string(fdt, flash_name, "compatible", "jedec,spi-nor");
+        qemu_fdt_setprop_cell(fdt, flash_name, "reg", i);
+    }
+
+    xip_name = g_strdup_printf("/soc/flash@%" HWADDR_PRIx,
+                               memmap[G233_DEV_XIP].base);
+    qemu_fdt_add_subnode(fdt, xip_name);
+    qemu_fdt_setprop_string(fdt, xip_name, "compatible", "mtd-rom");
+    qemu_fdt_setprop_cells(fdt, xip_name, "reg",
+        0x0, memmap[G233_DEV_XIP].base, 0x0, memmap[G233_DEV_XIP].size);
+    qemu_fdt_setprop_cell(fdt, xip_name, "bank-width", 4);
+}
+
+/*
+ * Describe the board for the kernel.  The PWM block is left out since it
+ * is only modelled as an unimplemented device.
+ */
+static void g233_create_fdt(G233MachineState *s)
+{
+    MachineState *ms = MACHINE(s);
+    g_autofree uint32_t *intc_phandles = NULL;
+    uint32_t phandle = 1, plic_phandle;
+
+    ms->fdt = create_device_tree(&s->fdt_size);
+    if (!ms->fdt) {
+        error_report("create_device_tree() failed");
+        exit(1);
+    }
+
+    qemu_fdt_setprop_string(ms->fdt, "/", "model", "Gevico G233");
+    qemu_fdt_setprop_string(ms->fdt, "/", "compatible", "gevico,g233");
+    qemu_fdt_setprop_cell(ms->fdt, "/", "#size-cells", 0x2);
+    qemu_fdt_setprop_cell(ms->fdt, "/", "#address-cells", 0x2);
+
+    qemu_fdt_add_subnode(ms->fdt, "/soc");
+    qemu_fdt_setprop(ms->fdt, "/soc", "ranges", NULL, 0);
+    qemu_fdt_setprop_string(ms->fdt, "/soc", "compatible", "simple-bus");
+    qemu_fdt_setprop_cell(ms->fdt, "/soc", "#size-cells", 0x2);
+    qemu_fdt_setprop_cell(ms->fdt, "/soc", "#address-cells", 0x2);
+
+    intc_phandles = g_new0(uint32_t, ms->smp.cpus);
+    g233_create_fdt_cpus(s, &phandle, intc_phandles);
+    g233_create_fdt_memory(s);
+    g233_create_fdt_intc(s, &phandle, intc_phandles, &plic_phandle);
+    g233_create_fdt_peripherals(s, &phandle, plic_phandle);
+}
+
+/*
+ * The harts start at 0x1004, so the trampoline lives there rather than
+ * at the start of the mask ROM.  Like the generic RISC-V reset vector it
+ * passes the hart ID in a0 and the DTB address in a1.
+ */
+static void g233_setup_reset_vec(G233MachineState *s, hwaddr start_addr,
+                                 hwaddr fdt_load_addr)
+{
+    RISCVHartArrayState *harts = &s->soc.cpus[0];
+    uint32_t reset_vec[10] = {
+        0,
+        0x00000297,                  /* 0x1004: auipc  t0, 0 */
+        0xf1402573,                  /* 0x1008: csrr   a0, mhartid */
+        0,
+        0,
+        0x00028067,                  /* 0x1014: jr     t0 */
+        start_addr,                  /* 0x1018: .dword start */
+        0,
+        fdt_load_addr,               /* 0x1020: .dword fdt_laddr */
+        0,
+    };
+    int i;
+
+    if (riscv_is_32bit(harts)) {
+        reset_vec[3] = 0x01c2a583;   /* 0x100c: lw     a1, 28(t0) */
+        reset_vec[4] = 0x0142a283;   /* 0x1010: lw     t0, 20(t0) */
+    } else {
+        reset_vec[3] = 0x01c2b583;   /* 0x100c: ld     a1, 28(t0) */
+        reset_vec[4] = 0x0142b283;   /* 0x1010: ld     t0, 20(t0) */
+        reset_vec[7] = (uint64_t)start_addr >> 32;
+        reset_vec[9] = (uint64_t)fdt_load_addr >> 32;
+    }
+
+    /* copy in the reset vector in little_endian byte order */
+    for (i = 0; i < ARRAY_SIZE(reset_vec); i++) {
+        reset_vec[i] = cpu_to_le32(reset_vec[i]);
+    }
+    rom_add_blob_fixed_as("mrom.reset", reset_vec, sizeof(reset_vec),
+                          g233_memmap[G233_DEV_MROM].base,
+                          &address_space_memory);
+}
+
+/*
+ * With direct-boot=on the harts skip the mask ROM and come out of reset
+ * at the kernel entry, with the same a0/a1 the trampoline would set up.
+ * Registered after the hart arrays, so this runs after cpu_reset().
+ */
+static void g233_direct_boot_reset(void *opaque)
+{
+    CPUState *cs;
+
+    CPU_FOREACH(cs) {
+        CPURISCVState *env = cpu_env(cs);
+
+        env->pc = env->kernel_addr;
+        env->gpr[10] = env->mhartid;   /* a0 */
+        env->gpr[11] = env->fdt_addr;  /* a1 */
+    }
+}
+
 static void g233_machine_init(MachineState *machine)
 {
     MachineClass *mc = MACHINE_GET_CLASS(machine);
@@ -178,6 +545,26 @@ static void g233_machine_init(MachineState *machine)
     MemoryRegion *sys_mem = get_system_memory();
     int i;
     RISCVBootInfo boot_info;
+    hwaddr kernel_entry = memmap[G233_DEV_DRAM].base;
+    uint64_t fdt_load_addr;
+    int socket_count = riscv_socket_count(machine);
+
+    if (socket_count > G233_SOCKETS_MAX) {
+        error_report("number of sockets/nodes should be less than %d",
+                     G233_SOCKETS_MAX);
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < socket_count; i++) {
+        if (!riscv_socket_check_hartids(machine, i)) {
+            error_report("discontinuous hartids in socket%d", i);
+            exit(EXIT_FAILURE);
+        }
+        if (riscv_socket_first_hartid(machine, i) < 0 ||
+            riscv_socket_hart_count(machine, i) <= 0) {
+            error_report("can't find harts for socket%d", i);
+            exit(EXIT_FAILURE);
+        }
+    }
 
     if (machine->ram_size < mc->default_ram_size) {
         char *sz = size_to_str(mc->default_ram_size);
@@ -196,26 +583,41 @@ static void g233_machine_init(MachineState *machine)
         memmap[G233_DEV_DRAM].base, machine->ram);
 
 
-    /* Mask ROM reset vector */
-    uint32_t reset_vec[5];
-    reset_vec[1] = 0x0010029b; /* 0x1004: addiw  t0, zero, 1 */
-    reset_vec[2] = 0x01f29293; /* 0x1008: slli   t0, t0, 0x1f */
-    reset_vec[3] = 0x00028067; /* 0x100c: jr     t0 */
-    reset_vec[0] = reset_vec[4] = 0;
-
-    /* copy in the reset vector in little_endian byte order */
-    for (i = 0; i < sizeof(reset_vec) >> 2; i++) {
-        reset_vec[i] = cpu_to_le32(reset_vec[i]);
+    /* Device tree: a user supplied -dtb replaces the generated one */
+    if (machine->dtb) {
+        machine->fdt = load_device_tree(machine->dtb, &s->fdt_size);
+        if (!machine->fdt) {
+            error_report("load_device_tree() failed");
+            exit(1);
+        }
+    } else {
+        g233_create_fdt(s);
     }
-    rom_add_blob_fixed_as("mrom.reset", reset_vec, sizeof(reset_vec),
-                          memmap[G233_DEV_MROM].base, &address_space_memory);
 
-    riscv_boot_info_init(&boot_info, &s->soc.cpus);
+    riscv_boot_info_init(&boot_info, &s->soc.cpus[0]);
+    boot_info.elf_in_ram = s->direct_boot;
     if (machine->kernel_filename) {
         riscv_load_kernel(machine, &boot_info,
                           memmap[G233_DEV_DRAM].base,
-                          false, NULL);
+                          true, NULL);
+        kernel_entry = boot_info.image_low_addr;
+    } else if (s->direct_boot) {
+        error_report("direct-boot requires -kernel");
+        exit(1);
+    }
+
+    fdt_load_addr = riscv_compute_fdt_addr(memmap[G233_DEV_DRAM].base,
+                                           memmap[G233_DEV_DRAM].size,
+                                           machine, &boot_info);
+    riscv_load_fdt(fdt_load_addr, machine->fdt);
+
+    /* Mask ROM reset vector */
+    g233_setup_reset_vec(s, kernel_entry, fdt_load_addr);
+    if (s->direct_boot) {
+        riscv_setup_direct_kernel(kernel_entry, fdt_load_addr);
+        qemu_register_reset(g233_direct_boot_reset, s);
     }
+
     //添加flash
 
     DeviceState *flash0 = qdev_new("w25x16");
@@ -223,11 +625,14 @@ static void g233_machine_init(MachineState *machine)
     BlockBackend *blk0 = blk_by_name("flash0");
     qdev_prop_set_drive_err(flash0, "drive", blk0, &error_fatal);
     qdev_prop_set_uint8(flash0, "cs", 0);
+    qdev_prop_set_bit(flash0, "xip", true);
     qdev_realize_and_unref(flash0, BUS(s->soc.spi.spi), &error_fatal);
     
     qemu_irq flash_cs0 = qdev_get_gpio_in_named(flash0, SSI_GPIO_CS, 0);
     sysbus_connect_irq(SYS_BUS_DEVICE(&s->soc.spi), 1, flash_cs0);
 
+    g233_xip_init(s, flash0);
+
    DeviceState *flash1 = qdev_new("w25x32");
     qdev_prop_set_uint8(flash1, "cs", 1);
     BlockBackend *blk1 = blk_by_name("flash1");
@@ -240,6 +645,20 @@ static void g233_machine_init(MachineState *machine)
 
 }
 
+static bool g233_machine_get_direct_boot(Object *obj, Error **errp)
+{
+    G233MachineState *s = RISCV_G233_MACHINE(obj);
+
+    return s->direct_boot;
+}
+
+static void g233_machine_set_direct_boot(Object *obj, bool value, Error **errp)
+{
+    G233MachineState *s = RISCV_G233_MACHINE(obj);
+
+    s->direct_boot = value;
+}
+
 static void g233_machine_instance_init(Object *obj)
 {
 
@@ -252,10 +671,24 @@ static void g233_machine_class_init(ObjectClass *oc, const void *data)
 
     mc->desc = "QEMU RISC-V G233 Board with Learning QEMU 2025";
     mc->init = g233_machine_init;
-    mc->max_cpus = 1;
+    mc->max_cpus = G233_CPUS_MAX;
+    mc->possible_cpu_arch_ids = riscv_numa_possible_cpu_arch_ids;
+    mc->cpu_index_to_instance_props = riscv_numa_cpu_index_to_props;
+    mc->get_default_cpu_node_id = riscv_numa_get_default_cpu_node_id;
+    mc->numa_mem_supported = true;
+    mc->cpu_cluster_has_numa_boundary = true;
     mc->default_cpu_type = TYPE_RISCV_CPU_GEVICO_G233;
     mc->default_ram_id = "riscv.g233.ram"; /* DDR */
     mc->default_ram_size = g233_memmap[G233_DEV_DRAM].size;
+
+    object_class_property_add_bool(oc, "direct-boot",
+                                   g233_machine_get_direct_boot,
+                                   g233_machine_set_direct_boot);
+    object_class_property_set_description(oc, "direct-boot",
+                                          "Set on/off to start the harts "
+                                          "at the -kernel entry, skipping "
+                                          "the mask ROM, with ELF segments "
+                                          "written straight into RAM");
 }
 
 static const TypeInfo g233_machine_typeinfo = {
@@ -1,12 +1,18 @@
 #include "qemu/osdep.h"
+#include "qapi/error.h"
 #include "hw/irq.h"
 #include "hw/qdev-properties.h"
 #include "hw/sysbus.h"
 #include "hw/ssi/ssi.h"
 #include "qemu/log.h"
+#include "qemu/main-loop.h"
 #include "qemu/module.h"
+#include "qemu/units.h"
 #include "hw/ssi/g233_spi.h"
 #include "qemu/fifo8.h"
+#include "migration/vmstate.h"
+#include "system/address-spaces.h"
+#include "system/dma.h"
 
 #ifndef STM_SPI_ERR_DEBUG
 #define STM_SPI_ERR_DEBUG 0
@@ -19,7 +25,10 @@
 } while (0)
 
 #define DB_PRINT(fmt, args...) DB_PRINT_L(1, fmt, ## args)
-#define FIFO_CAPACITY   1
+/* Bytes moved per DMA burst between the SSI bus and guest memory */
+#define DMA_BURST_SIZE  256
+/* Bytes moved per bottom half run, so a long DMA does not stall the VM */
+#define DMA_CHUNK_SIZE  (64 * KiB)
 
 static void g233_spi_reset(DeviceState *dev)
 {
@@ -30,6 +39,12 @@ static void g233_spi_reset(DeviceState *dev)
     s->spi_sr = 0x00000002;
     s->spi_dr = 0x0000000C;
     s->spi_csctrl = 0x00000000;
+    s->spi_dmaaddr = 0x00000000;
+    s->spi_dmalen = 0x00000000;
+    s->spi_dmacr = 0x00000000;
+    /* Line state is unknown after reset, drive every CS on the next write */
+    s->cs_synced = false;
+    qemu_bh_cancel(s->dma_bh);
     fifo8_reset(&s->tx_fifo);
     fifo8_reset(&s->rx_fifo);
     
@@ -37,15 +52,16 @@ static void g233_spi_reset(DeviceState *dev)
 
 static void g233_spi_update_cs(G233SPIState *s)
 {
-    int i;
     uint32_t cs_enable = s->spi_csctrl & 0x0F;        /* bits[3:0] for CS enable */
     uint32_t cs_active = (s->spi_csctrl >> 4) & 0x0F; /* bits[7:4] for CS active */
-
-    for (i = 0; i < s->num_cs; i++) {
-        /* CS is active low, only assert (drive low) if both enabled and active */
-        bool cs_assert = (cs_enable & (1 << i)) && (cs_active & (1 << i));
-        qemu_set_irq(s->cs_lines[i], cs_assert ? 0 : 1);
-    }
+    /* CS is active low, only assert (drive low) if both enabled and active */
+    uint64_t levels = ~(uint64_t)(cs_enable & cs_active);
+    uint64_t force = s->cs_synced ? 0 : UINT64_MAX;
+
+    /* Only lines that actually change level reach the slave select path */
+    s->cs_level = qemu_set_irq_group(s->cs_lines, s->num_cs, s->cs_level,
+                                     levels, force);
+    s->cs_synced = true;
     /*
     CS信号的极性不对：SPI flash通常是低电平有效的，而当前的代码中当spi_csctrl对应位为1时拉低CS，这样所有启用的CS都会同时被激活。
 
@@ -75,15 +91,26 @@ static void g233_spi_update_irq(G233SPIState *s)
         s->spi_sr |= G233_SPI_SR_TXE;
     }
 
-    if (s->spi_sr & (G233_SPI_SR_OVERRUN | G233_SPI_SR_UNDERRUN)) {
+    if (s->spi_sr & (G233_SPI_SR_OVERRUN | G233_SPI_SR_UNDERRUN |
+                     G233_SPI_SR_DMAERR)) {
         if (s->spi_cr2 & G233_SPI_CR2_ERRIE) {
             level = 1;
         }
     }
 
+    if ((s->spi_sr & G233_SPI_SR_DMADONE) &&
+        (s->spi_dmacr & G233_SPI_DMACR_DONEIE)) {
+        level = 1;
+    }
+
     qemu_set_irq(s->irq, level);
 }
 
+/*
+ * Every DR write is shifted out at once, so TXE and RXNE are up to date
+ * when the write returns.  The FIFO depth only sets how many received
+ * bytes can be buffered before OVERRUN.
+ */
 static void g233_spi_transfer(G233SPIState *s)
 {
     uint8_t tx;
@@ -104,16 +131,71 @@ static void g233_spi_transfer(G233SPIState *s)
     }
 
     s->spi_sr |= G233_SPI_SR_TXE;  // TX buffer is now empty
-    s->spi_sr &= ~G233_SPI_SR_BSY;  // Clear busy flag when transfer completes
+    /* Clear busy flag when transfer completes, unless DMA is still running */
+    if (!(s->spi_dmacr & G233_SPI_DMACR_START)) {
+        s->spi_sr &= ~G233_SPI_SR_BSY;
+    }
 }
 
+/*
+ * Fast-read DMA: clock DMALEN dummy bytes out on the bus and store the
+ * bytes shifted in by the selected device straight into guest memory at
+ * DMAADDR.  The guest sends the flash read command and address through
+ * DR first, so a whole image can be read with a single register write.
+ *
+ * At most DMA_CHUNK_SIZE bytes are moved per call; the rest of the
+ * transfer continues from a bottom half.  DMACR.START and SR.BSY stay
+ * set until the transfer completes and SR.DMADONE is raised.
+ */
+static void g233_spi_dma_run(void *opaque)
+{
+    G233SPIState *s = opaque;
+    uint8_t buf[DMA_BURST_SIZE];
+    uint32_t done = 0;
+
+    while (s->spi_dmalen && done < DMA_CHUNK_SIZE) {
+        uint32_t len = MIN(s->spi_dmalen, DMA_BURST_SIZE);
+
+        for (uint32_t i = 0; i < len; i++) {
+            buf[i] = ssi_transfer(s->spi, 0xff);
+        }
+        if (dma_memory_write(&s->dma_as, s->spi_dmaaddr, buf, len,
+                             MEMTXATTRS_UNSPECIFIED) != MEMTX_OK) {
+            qemu_log_mask(LOG_GUEST_ERROR,
+                          "%s: DMA write to 0x%" PRIx32 " failed\n",
+                          __func__, s->spi_dmaaddr);
+            s->spi_sr |= G233_SPI_SR_DMAERR;
+            break;
+        }
+        s->spi_dmaaddr += len;
+        s->spi_dmalen -= len;
+        done += len;
+    }
+
+    if (s->spi_dmalen && !(s->spi_sr & G233_SPI_SR_DMAERR)) {
+        qemu_bh_schedule(s->dma_bh);
+        return;
+    }
+
+    s->spi_dmacr &= ~G233_SPI_DMACR_START;
+    s->spi_sr &= ~G233_SPI_SR_BSY;
+    s->spi_sr |= G233_SPI_SR_DMADONE;
+    g233_spi_update_irq(s);
+}
 
+static void g233_spi_dma(G233SPIState *s)
+{
+    s->spi_sr &= ~(G233_SPI_SR_DMADONE | G233_SPI_SR_DMAERR);
+    s->spi_sr |= G233_SPI_SR_BSY;
+    s->spi_dmacr |= G233_SPI_DMACR_START;
+    g233_spi_dma_run(s);
+}
 
 static uint64_t g233_spi_read(void *opaque, hwaddr addr,
                                      unsigned int size)
 {
     G233SPIState *s = opaque;
-     uint32_t r;
+    uint32_t r = 0;
 
     DB_PRINT("Address: 0x%" HWADDR_PRIx "\n", addr);
 
@@ -146,6 +228,15 @@ static uint64_t g233_spi_read(void *opaque, hwaddr addr,
     case G233_SPI_CSCTRL:
         r=s->spi_csctrl;
         break;
+    case G233_SPI_DMAADDR:
+        r = s->spi_dmaaddr;
+        break;
+    case G233_SPI_DMALEN:
+        r = s->spi_dmalen;
+        break;
+    case G233_SPI_DMACR:
+        r = s->spi_dmacr;
+        break;
 
     default:
         qemu_log_mask(LOG_GUEST_ERROR, "%s: Bad offset 0x%" HWADDR_PRIx "\n",
@@ -194,6 +285,7 @@ static void g233_spi_write(void *opaque, hwaddr addr,
         if (value & G233_SPI_SR_UNDERRUN) {
             s->spi_sr &= ~G233_SPI_SR_UNDERRUN;
         }
+        s->spi_sr &= ~(value & (G233_SPI_SR_DMADONE | G233_SPI_SR_DMAERR));
         break;
     case G233_SPI_DR:
         if (!fifo8_is_full(&s->tx_fifo)) {
@@ -209,6 +301,23 @@ static void g233_spi_write(void *opaque, hwaddr addr,
         s->spi_csctrl = value;
         g233_spi_update_cs(s);
         break;
+    case G233_SPI_DMAADDR:
+        s->spi_dmaaddr = value;
+        break;
+    case G233_SPI_DMALEN:
+        s->spi_dmalen = value;
+        break;
+    case G233_SPI_DMACR:
+        if (s->spi_dmacr & G233_SPI_DMACR_START) {
+            /* A transfer in progress can be neither restarted nor stopped */
+            s->spi_dmacr = value | G233_SPI_DMACR_START;
+            break;
+        }
+        s->spi_dmacr = value;
+        if (value & G233_SPI_DMACR_START) {
+            g233_spi_dma(s);
+        }
+        break;
 
     default:
         qemu_log_mask(LOG_GUEST_ERROR,
@@ -233,6 +342,21 @@ static void g233_spi_realize(DeviceState *dev, Error **errp)
 
     int i;
 
+    if (s->fifo_depth == 0 || s->fifo_depth > G233_SPI_FIFO_MAX_DEPTH) {
+        error_setg(errp, "fifo-depth must be between 1 and %d",
+                   G233_SPI_FIFO_MAX_DEPTH);
+        return;
+    }
+
+    if (s->num_cs > G233_SPI_CS_MAX) {
+        error_setg(errp, "num-cs must be at most %d", G233_SPI_CS_MAX);
+        return;
+    }
+
+    address_space_init(&s->dma_as,
+                       s->dma_mr ? s->dma_mr : get_system_memory(),
+                       "g233-spi-dma");
+
     s->spi = ssi_create_bus(dev, "spi");
     sysbus_init_irq(sbd, &s->irq);
 
@@ -245,13 +369,56 @@ static void g233_spi_realize(DeviceState *dev, Error **errp)
                           TYPE_G233_SPI, 0x1000);
     sysbus_init_mmio(sbd, &s->mmio);
 
-    fifo8_create(&s->tx_fifo, FIFO_CAPACITY);
-    fifo8_create(&s->rx_fifo, FIFO_CAPACITY);
+    fifo8_create(&s->tx_fifo, s->fifo_depth);
+    fifo8_create(&s->rx_fifo, s->fifo_depth);
+
+    s->dma_bh = qemu_bh_new_guarded(g233_spi_dma_run, s,
+                                    &dev->mem_reentrancy_guard);
 
 }
 
+static int g233_spi_post_load(void *opaque, int version_id)
+{
+    G233SPIState *s = opaque;
+
+    if (s->spi_dmacr & G233_SPI_DMACR_START) {
+        qemu_bh_schedule(s->dma_bh);
+    }
+    return 0;
+}
+
+static const VMStateDescription vmstate_g233_spi = {
+    .name = TYPE_G233_SPI,
+    .version_id = 1,
+    .minimum_version_id = 1,
+    .post_load = g233_spi_post_load,
+    .fields = (const VMStateField[]) {
+        VMSTATE_UINT32(spi_cr1, G233SPIState),
+        VMSTATE_UINT32(spi_cr2, G233SPIState),
+        VMSTATE_UINT32(spi_sr, G233SPIState),
+        VMSTATE_UINT32(spi_dr, G233SPIState),
+        VMSTATE_UINT32(spi_csctrl, G233SPIState),
+        VMSTATE_UINT32(spi_dmaaddr, G233SPIState),
+        VMSTATE_UINT32(spi_dmalen, G233SPIState),
+        VMSTATE_UINT32(spi_dmacr, G233SPIState),
+        VMSTATE_FIFO8(tx_fifo, G233SPIState),
+        VMSTATE_FIFO8(rx_fifo, G233SPIState),
+        VMSTATE_UINT64(cs_level, G233SPIState),
+        VMSTATE_BOOL(cs_synced, G233SPIState),
+        VMSTATE_END_OF_LIST()
+    }
+};
+
 static const Property g233_spi_properties[] = {
     DEFINE_PROP_UINT32("num-cs", G233SPIState, num_cs, 4),
+    /*
+     * Depth of the hardware FIFOs.  With a depth of 1, a second DR write
+     * before DR is read overruns.
+     */
+    DEFINE_PROP_UINT32("fifo-depth", G233SPIState, fifo_depth,
+                       G233_SPI_FIFO_DEPTH),
+    DEFINE_PROP_LINK("dma", G233SPIState, dma_mr,
+                     TYPE_MEMORY_REGION, MemoryRegion *),
 };
 //是支持num_cs为4
 
@@ -262,6 +429,7 @@ static void g233_spi_class_init(ObjectClass *klass, const void *data)
     device_class_set_props(dc, g233_spi_properties);
     device_class_set_legacy_reset(dc, g233_spi_reset);
     dc->realize = g233_spi_realize;
+    dc->vmsd = &vmstate_g233_spi;
 }
 
 static const TypeInfo g233_spi_info = {
@@ -36,6 +36,16 @@ struct TCGCPUOps {
      */
     bool precise_smc;
 
+    /**
+     * @large_page_refill: After a miss, the softmmu TLB may refill a
+     *                     page from a large page filled earlier without
+     *                     calling @tlb_fill.  Only safe when the target
+     *                     has no side effects on a fill beyond those of
+     *                     the first one (A/D bits, PMP splits, PMU counts)
+     *                     and flushes the whole large page on invalidate.
+     */
+    bool large_page_refill;
+
     /**
      * @guest_default_memory_order: default barrier that is required
      *                              for the guest memory ordering.
@@ -49,5 +49,11 @@ PFlashCFI02 *pflash_cfi02_register(hwaddr base,
 #define TYPE_M25P80 "m25p80-generic"
 
 BlockBackend *m25p80_get_blk(DeviceState *dev);
+/*
+ * Read-only memory region onto the storage of a flash with the "xip"
+ * property set, which stays coherent with SPI program and erase
+ * commands; NULL without it.
+ */
+MemoryRegion *m25p80_get_xip(DeviceState *dev);
 
 #endif
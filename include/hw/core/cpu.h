@@ -206,6 +206,9 @@ struct CPUClass {
 /* Use a fully associative victim tlb of 8 entries. */
 #define CPU_VTLB_SIZE 8
 
+/* Remember the translations of up to 4 large pages per MMU mode. */
+#define CPU_LTLB_SIZE 4
+
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
  * so the layout is not as critical as that of CPUTLBEntry. This is
@@ -293,6 +296,15 @@ typedef struct CPUTLBDesc {
     CPUTLBEntry vtable[CPU_VTLB_SIZE];
     CPUTLBEntryFull vfulltlb[CPU_VTLB_SIZE];
     CPUTLBEntryFull *fulltlb;
+    /*
+     * Large pages seen by tlb_set_page_full(), from which further
+     * TARGET_PAGE_SIZE entries are filled without asking the target.
+     * @laddr is the virtual base of each page, or -1 if unused, and
+     * @lfulltlb the translation of that base.
+     */
+    size_t lindex;
+    vaddr laddr[CPU_LTLB_SIZE];
+    CPUTLBEntryFull lfulltlb[CPU_LTLB_SIZE];
 } CPUTLBDesc;
 
 /*
@@ -315,6 +327,7 @@ typedef struct CPUTLBCommon {
     size_t full_flush_count;
     size_t part_flush_count;
     size_t elide_flush_count;
+    size_t large_fill_count;
 } CPUTLBCommon;
 
 /*
@@ -34,6 +34,25 @@ static inline void qemu_irq_pulse(qemu_irq irq)
     qemu_set_irq(irq, 0);
 }
 
+/**
+ * qemu_set_irq_group: Update a group of IRQ lines in one call.
+ *
+ * @irqs: array of (at most 64) IRQ lines making up the group
+ * @n: number of lines in @irqs
+ * @cur: bitmap of the levels the lines are currently known to be at
+ * @levels: bitmap of the new levels, bit i driving @irqs[i]
+ * @force: bitmap of lines to drive even if their level is unchanged
+ *
+ * Only lines whose level differs from @cur, or that are set in @force,
+ * are passed to qemu_set_irq(); no-op transitions are skipped.  This is
+ * useful for outputs such as chip selects that the guest rewrites as a
+ * whole register but usually changes one bit at a time.
+ *
+ * Returns the new level bitmap, to be passed as @cur on the next call.
+ */
+uint64_t qemu_set_irq_group(qemu_irq *irqs, int n, uint64_t cur,
+                            uint64_t levels, uint64_t force);
+
 /*
  * Init a single IRQ. The irq is assigned with a handler, an opaque data
  * and the interrupt number.
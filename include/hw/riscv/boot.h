@@ -36,6 +36,8 @@ typedef struct RISCVBootInfo {
     ssize_t initrd_size;
 
     bool is_32bit;
+    /* Write ELF segments straight into guest memory instead of ROM blobs */
+    bool elf_in_ram;
 } RISCVBootInfo;
 
 bool riscv_is_32bit(RISCVHartArrayState *harts);
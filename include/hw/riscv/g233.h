@@ -26,6 +26,9 @@
 #include "hw/gpio/sifive_gpio.h"
 #include "hw/ssi/g233_spi.h"
 
+#define G233_CPUS_MAX 8
+#define G233_SOCKETS_MAX 8
+
 #define TYPE_RISCV_G233_SOC "riscv.gevico.g233.soc"
 #define RISCV_G233_SOC(obj) \
     OBJECT_CHECK(G233SoCState, (obj), TYPE_RISCV_G233_SOC)
@@ -35,7 +38,9 @@ typedef struct G233SoCState {
     DeviceState parent_obj;
 
     /*< public >*/
-    RISCVHartArrayState cpus;
+    /* One hart array per socket (NUMA node) */
+    RISCVHartArrayState cpus[G233_SOCKETS_MAX];
+    int num_sockets;
     DeviceState *plic;
     DeviceState *uart0;
     DeviceState *pwm0;
@@ -54,6 +59,9 @@ typedef struct G233MachineState {
 
     /*< public >*/
     G233SoCState soc;
+    MemoryRegion xip;
+    int fdt_size;
+    bool direct_boot;
 
 } G233MachineState;
 
@@ -65,6 +73,7 @@ enum {
     G233_DEV_UART0, /* PL011 */
     G233_DEV_SPI0,
     G233_DEV_PWM0,
+    G233_DEV_XIP,
     G233_DEV_DRAM
 };
 
@@ -76,7 +85,9 @@ enum {
 
 };
 
-#define G233_PLIC_HART_CONFIG "M"
+#define G233_CLINT_TIMEBASE_FREQ 32768
+
+#define G233_PLIC_HART_CONFIG "MS"
 /*
  * Freedom E310 G002 and G003 supports 52 interrupt sources while
  * Freedom E310 G000 supports 51 interrupt sources. We use the value
@@ -11,13 +11,25 @@
 #define G233_SPI_SR      0x08
 #define G233_SPI_DR      0x0C
 #define G233_SPI_CSCTRL   0x10
+#define G233_SPI_DMAADDR  0x14
+#define G233_SPI_DMALEN   0x18
+#define G233_SPI_DMACR    0x1C
+
+#define G233_SPI_FIFO_DEPTH     16
+#define G233_SPI_FIFO_MAX_DEPTH 256
+#define G233_SPI_CS_MAX         64
 
 /* SPI_CR2*/
 #define G233_SPI_CR2_TXEIE  (1<<7)
 #define G233_SPI_CR2_RXNEIE  (1<<6)
 #define G233_SPI_CR2_ERRIE   (1<<5)
 #define G233_SPI_CR2_SSOE    (1<<4)
+/* SPI_DMACR */
+#define G233_SPI_DMACR_START   (1<<0)
+#define G233_SPI_DMACR_DONEIE  (1<<1)
 /* SPI_SR */
+#define G233_SPI_SR_DMAERR   (1<<9)
+#define G233_SPI_SR_DMADONE  (1<<8)
 #define G233_SPI_SR_BSY      (1<<7)
 #define G233_SPI_SR_OVERRUN  (1<<3)
 #define G233_SPI_SR_UNDERRUN (1<<2)
@@ -34,19 +46,29 @@ struct G233SPIState {
     SSIBus *spi;
     /* <public> */
     uint32_t num_cs;
+    uint32_t fifo_depth;
     MemoryRegion mmio;
+    MemoryRegion *dma_mr;
+    AddressSpace dma_as;
+    QEMUBH *dma_bh;
 
     uint32_t spi_cr1;
     uint32_t spi_cr2;
     uint32_t spi_sr;
     uint32_t spi_dr;
     uint32_t spi_csctrl;
+    uint32_t spi_dmaaddr;
+    uint32_t spi_dmalen;
+    uint32_t spi_dmacr;
 
     Fifo8 tx_fifo;
     Fifo8 rx_fifo;
 
 
     qemu_irq *cs_lines;
+    /* Last levels driven on cs_lines; only valid once cs_synced is set */
+    uint64_t cs_level;
+    bool cs_synced;
 };
 
 #endif 
\ No newline at end of file
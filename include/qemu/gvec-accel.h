@@ -0,0 +1,66 @@
+/*
+ * Host-vector acceleration of wide element-wise operations
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#ifndef QEMU_GVEC_ACCEL_H
+#define QEMU_GVEC_ACCEL_H
+
+typedef enum GVecAccelOp {
+    GVEC_ACCEL_ADD8,
+    GVEC_ACCEL_ADD16,
+    GVEC_ACCEL_ADD32,
+    GVEC_ACCEL_ADD64,
+    GVEC_ACCEL_SUB8,
+    GVEC_ACCEL_SUB16,
+    GVEC_ACCEL_SUB32,
+    GVEC_ACCEL_SUB64,
+    GVEC_ACCEL_AND,
+    GVEC_ACCEL_OR,
+    GVEC_ACCEL_XOR,
+    GVEC_ACCEL_ANDC,
+    GVEC_ACCEL_NB_OPS,
+} GVecAccelOp;
+
+/*
+ * Compute D = A op B over whole host vectors from the start of the
+ * operands, and return the number of bytes done, at most @oprsz.
+ * D may be A or B, but must not otherwise overlap them.
+ */
+typedef intptr_t (*GVecAccelFn)(void *d, const void *a, const void *b,
+                                intptr_t oprsz);
+
+/* Operands shorter than this are cheaper to loop over inline. */
+#define GVEC_ACCEL_MIN_BYTES  64
+
+/* The implementations for the best vector unit of the host. */
+extern const GVecAccelFn *gvec_accel_fns;
+
+/*
+ * gvec_accel:
+ * @op: the operation
+ * @d, @a, @b, @oprsz: as for #GVecAccelFn
+ *
+ * Run @op with the host vector unit if it is worthwhile.  Return the
+ * number of bytes done, which the caller completes element by element.
+ */
+static inline intptr_t gvec_accel(GVecAccelOp op, void *d, const void *a,
+                                  const void *b, intptr_t oprsz)
+{
+    GVecAccelFn fn = gvec_accel_fns[op];
+
+    if (fn && oprsz >= GVEC_ACCEL_MIN_BYTES) {
+        return fn(d, a, b, oprsz);
+    }
+    return 0;
+}
+
+/* Name of the implementation currently selected. */
+const char *gvec_accel_name(void);
+
+/* Step down to the next best implementation, for benchmarking. */
+bool test_gvec_accel_next(void);
+
+#endif /* QEMU_GVEC_ACCEL_H */
@@ -63,6 +63,7 @@ union qemu_plugin_cb_sig {
     qemu_plugin_vcpu_mem_cb_t        vcpu_mem;
     qemu_plugin_vcpu_syscall_cb_t    vcpu_syscall;
     qemu_plugin_vcpu_syscall_ret_cb_t vcpu_syscall_ret;
+    qemu_plugin_vcpu_sample_cb_t     vcpu_sample;
     void *generic;
 };
 
@@ -70,6 +71,7 @@ enum plugin_dyn_cb_type {
     PLUGIN_CB_REGULAR,
     PLUGIN_CB_COND,
     PLUGIN_CB_MEM_REGULAR,
+    PLUGIN_CB_MEM_BUFFERED,
     PLUGIN_CB_INLINE_ADD_U64,
     PLUGIN_CB_INLINE_STORE_U64,
 };
@@ -96,6 +98,13 @@ struct qemu_plugin_conditional_cb {
     uint64_t imm;
 };
 
+struct qemu_plugin_buffered_cb {
+    struct qemu_plugin_mem_buffer *buf;
+    TCGHelperInfo *info;
+    enum qemu_plugin_mem_rw rw;
+    uint32_t tag;
+};
+
 /*
  * A dynamic callback has an insertion point that is determined at run-time.
  * Usually the insertion point is somewhere in the code cache; think for
@@ -107,6 +116,7 @@ struct qemu_plugin_dyn_cb {
         struct qemu_plugin_regular_cb regular;
         struct qemu_plugin_conditional_cb cond;
         struct qemu_plugin_inline_cb inline_insn;
+        struct qemu_plugin_buffered_cb buffered;
     };
 };
 
@@ -120,6 +130,9 @@ struct qemu_plugin_insn {
 
     /* if set, the instruction calls helpers that might access guest memory */
     bool mem_helper;
+
+    /* number of inline memory callback sites, for loads and stores */
+    unsigned int mem_sites[2];
 };
 
 /* A scoreboard is an array of values, indexed by vcpu_index */
@@ -128,6 +141,25 @@ struct qemu_plugin_scoreboard {
     QLIST_ENTRY(qemu_plugin_scoreboard) entry;
 };
 
+/*
+ * A buffer of memory access records.  Each vcpu's entry in @score holds
+ * a struct qemu_plugin_mem_buffer_slot with room for @capacity records.
+ */
+struct qemu_plugin_mem_buffer {
+    /* owner; the buffer is freed when it is reset or uninstalled */
+    struct qemu_plugin_ctx *ctx;
+    struct qemu_plugin_scoreboard *score;
+    size_t capacity;
+    qemu_plugin_vcpu_mem_buffer_cb_t cb;
+    void *userp;
+    QLIST_ENTRY(qemu_plugin_mem_buffer) entry;
+};
+
+struct qemu_plugin_mem_buffer_slot {
+    uint64_t count;
+    qemu_plugin_mem_record records[];
+};
+
 /* Internal context for this TranslationBlock */
 struct qemu_plugin_tb {
     GPtrArray *insns;
@@ -173,6 +205,9 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
 
 void qemu_plugin_flush_cb(void);
 
+void qemu_plugin_mem_buffer_flush(uint32_t vcpu_index,
+                                  struct qemu_plugin_mem_buffer *buf);
+
 void qemu_plugin_atexit_cb(void);
 
 void qemu_plugin_add_dyn_cb_arr(GArray *arr);
@@ -72,11 +72,17 @@ typedef uint64_t qemu_plugin_id_t;
  * - added qemu_plugin_write_memory_hwaddr
  * - added qemu_plugin_write_register
  * - added qemu_plugin_translate_vaddr
+ *
+ * version 6:
+ * - added qemu_plugin_mem_buffer_new
+ * - added qemu_plugin_mem_buffer_free
+ * - added qemu_plugin_register_vcpu_mem_buffer
+ * - added qemu_plugin_register_vcpu_sample_cb
  */
 
 extern QEMU_PLUGIN_EXPORT int qemu_plugin_version;
 
-#define QEMU_PLUGIN_VERSION 5
+#define QEMU_PLUGIN_VERSION 6
 
 /**
  * struct qemu_info_t - system information for plugins
@@ -705,6 +711,91 @@ void qemu_plugin_register_vcpu_mem_inline_per_vcpu(
     qemu_plugin_u64 entry,
     uint64_t imm);
 
+/** struct qemu_plugin_mem_buffer - opaque per-vCPU buffer of accesses */
+struct qemu_plugin_mem_buffer;
+
+/**
+ * typedef qemu_plugin_mem_record - a buffered memory access
+ * @vaddr: the virtual address of the access
+ * @info: an opaque handle for further queries about the access
+ * @tag: the value given to qemu_plugin_register_vcpu_mem_buffer()
+ *
+ * Only the queries that decode @info itself, such as
+ * qemu_plugin_mem_size_shift() and qemu_plugin_mem_is_store(), can be
+ * used on buffered records.  The value and hardware address of the
+ * access are no longer available by the time the record is delivered.
+ */
+typedef struct qemu_plugin_mem_record {
+    uint64_t vaddr;
+    qemu_plugin_meminfo_t info;
+    uint32_t tag;
+} qemu_plugin_mem_record;
+
+/**
+ * typedef qemu_plugin_vcpu_mem_buffer_cb_t - buffered memory callback type
+ * @vcpu_index: the vCPU that performed the accesses
+ * @records: the accesses, oldest first
+ * @n: number of entries in @records
+ * @userdata: the userdata given to qemu_plugin_mem_buffer_new()
+ */
+typedef void (*qemu_plugin_vcpu_mem_buffer_cb_t)(
+    unsigned int vcpu_index,
+    const qemu_plugin_mem_record *records,
+    size_t n,
+    void *userdata);
+
+/**
+ * qemu_plugin_mem_buffer_new() - allocate a buffer of memory accesses
+ * @id: plugin ID
+ * @capacity: number of records each vCPU can hold before a flush
+ * @cb: callback receiving the records
+ * @userdata: opaque pointer passed to @cb
+ *
+ * Each vCPU gets room for @capacity records, rounded up to at least
+ * 256.  A vCPU hands its records to @cb when its buffer is about to
+ * fill up, when it goes idle, makes a syscall or exits, and at the end
+ * of execution.  Every record is delivered exactly once, in execution
+ * order for a given vCPU.
+ *
+ * Returns a buffer to use with qemu_plugin_register_vcpu_mem_buffer().
+ * It is freed with qemu_plugin_mem_buffer_free(), or when the plugin is
+ * reset or uninstalled, which drops any records still pending.
+ */
+QEMU_PLUGIN_API
+struct qemu_plugin_mem_buffer *
+qemu_plugin_mem_buffer_new(qemu_plugin_id_t id,
+                           size_t capacity,
+                           qemu_plugin_vcpu_mem_buffer_cb_t cb,
+                           void *userdata);
+
+/**
+ * qemu_plugin_mem_buffer_free() - free a buffer of memory accesses
+ * @buf: buffer to free
+ *
+ * Records still pending are dropped.  Buffers are flushed before the
+ * atexit callbacks run, so freeing them there loses nothing.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf);
+
+/**
+ * qemu_plugin_register_vcpu_mem_buffer() - buffer memory accesses
+ * @insn: handle for instruction to instrument
+ * @buf: buffer receiving the records
+ * @rw: monitor reads, writes or both
+ * @tag: value stored in every record, e.g. an index identifying @insn
+ *
+ * This is a cheaper alternative to qemu_plugin_register_vcpu_mem_cb().
+ * Instead of calling out for every memory access of the instruction,
+ * the generated code appends a record to the vCPU's buffer, and the
+ * callback of @buf later receives them in batches.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_register_vcpu_mem_buffer(struct qemu_plugin_insn *insn,
+                                          struct qemu_plugin_mem_buffer *buf,
+                                          enum qemu_plugin_mem_rw rw,
+                                          uint32_t tag);
+
 /**
  * qemu_plugin_request_time_control() - request the ability to control time
  *
@@ -751,6 +842,67 @@ void
 qemu_plugin_register_vcpu_syscall_ret_cb(qemu_plugin_id_t id,
                                          qemu_plugin_vcpu_syscall_ret_cb_t cb);
 
+/**
+ * enum qemu_plugin_sample_trigger - what drives a sampling profiler
+ *
+ * @QEMU_PLUGIN_SAMPLE_HOST_TIME: sample every running vCPU each time
+ *   the period, in nanoseconds of host time, elapses
+ * @QEMU_PLUGIN_SAMPLE_INSNS: sample a vCPU each time it has executed
+ *   the period in guest instructions
+ */
+enum qemu_plugin_sample_trigger {
+    QEMU_PLUGIN_SAMPLE_HOST_TIME,
+    QEMU_PLUGIN_SAMPLE_INSNS,
+};
+
+/**
+ * typedef qemu_plugin_sample - a profiler sample
+ * @vcpu_index: the sampled vCPU
+ * @mmu_idx: MMU index of the vCPU's data accesses, which is how TCG
+ *   tracks the privilege level; its meaning is target specific
+ * @pc: guest virtual address of the next instruction to execute
+ */
+typedef struct {
+    unsigned int vcpu_index;
+    int mmu_idx;
+    uint64_t pc;
+} qemu_plugin_sample;
+
+typedef void
+(*qemu_plugin_vcpu_sample_cb_t)(qemu_plugin_id_t id,
+                                const qemu_plugin_sample *sample,
+                                void *userdata);
+
+/**
+ * qemu_plugin_register_vcpu_sample_cb() - register a sampling profiler
+ * @id: plugin ID
+ * @trigger: what drives the samples
+ * @period: nanoseconds or instructions between two samples of a vCPU
+ * @cb: callback function, NULL to stop sampling
+ * @userdata: any plugin data to pass to the @cb
+ *
+ * Sampling does not instrument individual instructions. Host time
+ * samples are taken when the vCPU next leaves the code cache, which a
+ * timer thread forces every @period nanoseconds (rounded down to whole
+ * milliseconds); halted vCPUs are not sampled. Instruction samples only
+ * cost an inline add and compare per executed block, so they are taken
+ * at the start of the first block that reaches @period.
+ *
+ * @cb runs on the sampled vCPU with read access to its registers, so it
+ * can walk the guest stack with qemu_plugin_read_register() and
+ * qemu_plugin_read_memory_vaddr().
+ *
+ * A plugin has a single sampler: a later call replaces the trigger,
+ * period and callback of an earlier one. Changing the trigger or
+ * period once vCPUs run only takes effect for code translated after it.
+ */
+QEMU_PLUGIN_API
+void qemu_plugin_register_vcpu_sample_cb(qemu_plugin_id_t id,
+                                         enum qemu_plugin_sample_trigger trigger,
+                                         uint64_t period,
+                                         qemu_plugin_vcpu_sample_cb_t cb,
+                                         void *userdata);
+
 
 /**
  * qemu_plugin_insn_disas() - return disassembly string for instruction
@@ -21,6 +21,9 @@ void perf_report_prologue(const void *start, size_t size);
 void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
                       const void *start);
 
+/* Forget the JITted guest code, the code buffer is being reset. */
+void perf_report_reset(void);
+
 /* Stop writing perf-<pid>.map and/or jit-<pid>.dump. */
 void perf_exit(void);
 #else
@@ -41,6 +44,10 @@ static inline void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
 {
 }
 
+static inline void perf_report_reset(void)
+{
+}
+
 static inline void perf_exit(void)
 {
 }
@@ -429,6 +429,11 @@ struct TCGContext {
      */
     bool carry_live;
 
+    /* Register allocator statistics, see tcg_reg_alloc_stats(). */
+    size_t ra_store_count;
+    size_t ra_spill_count;
+    size_t ra_reload_count;
+
     GHashTable *const_table[TCG_TYPE_COUNT];
     TCGTempSet free_temps[TCG_TYPE_COUNT];
     TCGTemp temps[TCG_MAX_TEMPS]; /* globals first, temps after */
@@ -655,6 +660,16 @@ void tcg_region_reset_all(void);
 size_t tcg_code_size(void);
 size_t tcg_code_capacity(void);
 
+/**
+ * tcg_reg_alloc_stats:
+ * @stores: stores of register values back to memory, e.g. globals to env
+ * @spills: those of @stores that were made only to free a register
+ * @reloads: loads of values from memory into a register
+ *
+ * Sum the register allocator statistics of all TCG contexts.
+ */
+void tcg_reg_alloc_stats(size_t *stores, size_t *spills, size_t *reloads);
+
 /**
  * tcg_tb_insert:
  * @tb: translation block to insert
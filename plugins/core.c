@@ -19,7 +19,14 @@
 #include "qemu/queue.h"
 #include "qemu/rcu_queue.h"
 #include "qemu/rcu.h"
+#include "qemu/timer.h"
+#include "accel/tcg/cpu-mmu-index.h"
+#include "accel/tcg/getpc.h"
+#include "exec/cpu-common.h"
 #include "exec/tb-flush.h"
+#include "exec/translation-block.h"
+#include "tcg/insn-start-words.h"
+#include "tcg/tcg.h"
 #include "tcg/tcg-op-common.h"
 #include "plugin.h"
 
@@ -282,6 +289,7 @@ void qemu_plugin_vcpu_exit_hook(CPUState *cpu)
 {
     bool success;
 
+    plugin_mem_buffers_flush(cpu->cpu_index);
     qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_RW_REGS);
     plugin_vcpu_cb__simple(cpu, QEMU_PLUGIN_EV_VCPU_EXIT);
     qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_NO_REGS);
@@ -465,6 +473,320 @@ void plugin_register_vcpu_mem_cb(GArray **arr,
     dyn_cb->regular = regular_cb;
 }
 
+void plugin_register_vcpu_mem_buffer(GArray **arr,
+                                     struct qemu_plugin_mem_buffer *buf,
+                                     enum qemu_plugin_mem_rw rw,
+                                     uint32_t tag)
+{
+    static TCGHelperInfo info = {
+        /* The records reach the helper through host memory only. */
+        .flags = TCG_CALL_NO_RWG,
+        /*
+         * Match qemu_plugin_mem_buffer_flush:
+         *   void (*)(uint32_t, struct qemu_plugin_mem_buffer *)
+         */
+        .typemask = (dh_typemask(void, 0) |
+                     dh_typemask(i32, 1) |
+                     dh_typemask(ptr, 2))
+    };
+
+    struct qemu_plugin_dyn_cb *dyn_cb = plugin_get_dyn_cb(arr);
+    struct qemu_plugin_buffered_cb buffered_cb = { .buf = buf,
+                                                   .info = &info,
+                                                   .rw = rw,
+                                                   .tag = tag };
+    dyn_cb->type = PLUGIN_CB_MEM_BUFFERED;
+    dyn_cb->buffered = buffered_cb;
+}
+
+static struct qemu_plugin_mem_buffer_slot *
+plugin_mem_buffer_slot(struct qemu_plugin_mem_buffer *buf,
+                       unsigned int vcpu_index)
+{
+    GArray *data = buf->score->data;
+
+    return (void *)(data->data + vcpu_index * g_array_get_element_size(data));
+}
+
+/*
+ * Disable CFI checks.
+ * The callback function has been loaded from an external library so we do not
+ * have type information
+ */
+QEMU_DISABLE_CFI
+void qemu_plugin_mem_buffer_flush(uint32_t vcpu_index,
+                                  struct qemu_plugin_mem_buffer *buf)
+{
+    struct qemu_plugin_mem_buffer_slot *slot =
+        plugin_mem_buffer_slot(buf, vcpu_index);
+    size_t n = slot->count;
+
+    if (n) {
+        buf->cb(vcpu_index, slot->records, n, buf->userp);
+        slot->count = 0;
+    }
+}
+
+static void plugin_mem_buffers_flush(unsigned int vcpu_index)
+{
+    struct qemu_plugin_mem_buffer *buf;
+
+    if (QLIST_EMPTY(&plugin.mem_buffers)) {
+        return;
+    }
+
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_FOREACH(buf, &plugin.mem_buffers, entry) {
+        qemu_plugin_mem_buffer_flush(vcpu_index, buf);
+    }
+    qemu_rec_mutex_unlock(&plugin.lock);
+}
+
+/*
+ * Accesses made from helpers are delivered right away, after whatever
+ * the generated code buffered before them: the room reserved at the
+ * start of an instruction only accounts for its inline accesses.
+ */
+QEMU_DISABLE_CFI
+static void plugin_mem_buffer_deliver(unsigned int vcpu_index,
+                                      struct qemu_plugin_buffered_cb *cb,
+                                      qemu_plugin_meminfo_t info,
+                                      uint64_t vaddr)
+{
+    qemu_plugin_mem_record rec = { .vaddr = vaddr,
+                                   .info = info,
+                                   .tag = cb->tag };
+
+    qemu_plugin_mem_buffer_flush(vcpu_index, cb->buf);
+    cb->buf->cb(vcpu_index, &rec, 1, cb->buf->userp);
+}
+
+/*
+ * Sampling profilers.
+ *
+ * Host time samplers queue work on the vCPUs from a thread of their own,
+ * so the samples are taken once a vCPU has left the code cache and its
+ * state is fully synchronised. Instruction samplers count instructions
+ * at the start of every block and take the sample from there.
+ */
+
+/*
+ * Disable CFI checks.
+ * The callback function has been loaded from an external library so we do not
+ * have type information
+ */
+QEMU_DISABLE_CFI
+static void plugin_sample__locked(CPUState *cpu, struct qemu_plugin_ctx *ctx,
+                                  uint64_t pc)
+{
+    struct qemu_plugin_cb *cb = ctx->callbacks[QEMU_PLUGIN_EV_VCPU_SAMPLE];
+    qemu_plugin_sample sample = {
+        .vcpu_index = cpu->cpu_index,
+        .mmu_idx = cpu_mmu_index(cpu, false),
+        .pc = pc,
+    };
+
+    if (cb == NULL) {
+        return;
+    }
+    qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_R_REGS);
+    cb->f.vcpu_sample(ctx->id, &sample, cb->udata);
+    qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_NO_REGS);
+}
+
+static void plugin_sample__async(CPUState *cpu, run_on_cpu_data data)
+{
+    struct qemu_plugin_ctx *ctx;
+
+    QEMU_LOCK_GUARD(&plugin.lock);
+    /* the plugin may have been reset or uninstalled since */
+    QTAILQ_FOREACH(ctx, &plugin.ctxs, entry) {
+        struct qemu_plugin_sampler *s = ctx->sampler;
+
+        if (ctx == data.host_ptr && s) {
+            struct qemu_plugin_sampler_vcpu *v =
+                qemu_plugin_scoreboard_find(s->vcpus, cpu->cpu_index);
+
+            v->pending = false;
+            if (s->trigger == QEMU_PLUGIN_SAMPLE_HOST_TIME && !cpu->halted) {
+                plugin_sample__locked(cpu, ctx, cpu->cc->get_pc(cpu));
+            }
+            return;
+        }
+    }
+}
+
+static void plugin_sample_kick__locked(gpointer k, gpointer v, gpointer udata)
+{
+    struct qemu_plugin_sampler *s = udata;
+    CPUState *cpu = container_of(k, CPUState, cpu_index);
+    struct qemu_plugin_sampler_vcpu *vcpu;
+
+    /* scoreboards grow after the vCPU is registered, with the lock dropped */
+    if (cpu->cpu_index >= plugin.scoreboard_alloc_size) {
+        return;
+    }
+
+    vcpu = qemu_plugin_scoreboard_find(s->vcpus, cpu->cpu_index);
+    /* a vCPU that does not drain its work queue gets a single sample */
+    if (!vcpu->pending && !qatomic_read(&cpu->halted)) {
+        vcpu->pending = true;
+        async_run_on_cpu(cpu, plugin_sample__async,
+                         RUN_ON_CPU_HOST_PTR(s->ctx));
+    }
+}
+
+static void *plugin_sampler_thread(void *opaque)
+{
+    struct qemu_plugin_sampler *s = opaque;
+    int ms = MAX(s->period / SCALE_MS, 1);
+
+    while (qemu_sem_timedwait(&s->stop, ms) < 0) {
+        /* never wait for the lock, the thread is stopped with it held */
+        if (qemu_rec_mutex_trylock(&plugin.lock) == 0) {
+            g_hash_table_foreach(plugin.cpu_ht, plugin_sample_kick__locked, s);
+            qemu_rec_mutex_unlock(&plugin.lock);
+        }
+    }
+    return NULL;
+}
+
+static void plugin_sampler_stop(struct qemu_plugin_sampler *s)
+{
+    if (s->running) {
+        qemu_sem_post(&s->stop);
+        qemu_thread_join(&s->thread);
+        s->running = false;
+    }
+}
+
+/*
+ * Called at the start of the block in which the vCPU reaches the period.
+ * The globals are in sync there, but only CF_PCREL targets keep the pc
+ * up to date across chained blocks: otherwise unwind GETPC(), which
+ * points into the block being entered, to its first instruction.
+ */
+static void plugin_sample_insns(unsigned int vcpu_index, void *udata)
+{
+    struct qemu_plugin_sampler *s = udata;
+    CPUState *cpu = current_cpu;
+    uint64_t data[INSN_START_WORDS];
+    uint64_t pc;
+
+    if ((cpu->tcg_cflags & CF_PCREL) ||
+        !cpu_unwind_state_data(cpu, GETPC(), data)) {
+        pc = cpu->cc->get_pc(cpu);
+    } else {
+        pc = data[0];
+    }
+
+    qemu_plugin_u64_set(s->insns, vcpu_index, 0);
+
+    QEMU_LOCK_GUARD(&plugin.lock);
+    if (s->trigger == QEMU_PLUGIN_SAMPLE_INSNS) {
+        plugin_sample__locked(cpu, s->ctx, pc);
+    }
+}
+
+static void plugin_sample_tb_trans(struct qemu_plugin_tb *tb)
+{
+    struct qemu_plugin_cb *cb;
+
+    if (tb_cflags(tcg_ctx->gen_tb) & CF_MEMI_ONLY) {
+        return;
+    }
+
+    QLIST_FOREACH_RCU(cb, &plugin.cb_lists[QEMU_PLUGIN_EV_VCPU_SAMPLE],
+                      entry) {
+        struct qemu_plugin_sampler *s = cb->ctx->sampler;
+
+        if (s->trigger != QEMU_PLUGIN_SAMPLE_INSNS) {
+            continue;
+        }
+        plugin_register_inline_op_on_entry(&tb->cbs, 0,
+                                           QEMU_PLUGIN_INLINE_ADD_U64,
+                                           s->insns, tb->n);
+        plugin_register_dyn_cond_cb__udata(&tb->cbs, plugin_sample_insns,
+                                           QEMU_PLUGIN_CB_R_REGS,
+                                           QEMU_PLUGIN_COND_GE,
+                                           s->insns, s->period, s);
+    }
+}
+
+void qemu_plugin_register_vcpu_sample_cb(qemu_plugin_id_t id,
+                                         enum qemu_plugin_sample_trigger trigger,
+                                         uint64_t period,
+                                         qemu_plugin_vcpu_sample_cb_t cb,
+                                         void *udata)
+{
+    struct qemu_plugin_ctx *ctx;
+    struct qemu_plugin_sampler *s;
+
+    g_assert(period);
+
+    QEMU_LOCK_GUARD(&plugin.lock);
+    ctx = plugin_id_to_ctx_locked(id);
+    /* if the plugin is on its way out, ignore this request */
+    if (unlikely(ctx->uninstalling)) {
+        return;
+    }
+
+    s = ctx->sampler;
+    if (s == NULL) {
+        s = g_new0(struct qemu_plugin_sampler, 1);
+        s->ctx = ctx;
+        s->vcpus = plugin_scoreboard_new(
+            sizeof(struct qemu_plugin_sampler_vcpu));
+        s->insns = (qemu_plugin_u64) {
+            .score = s->vcpus,
+            .offset = offsetof(struct qemu_plugin_sampler_vcpu, insns),
+        };
+        qemu_sem_init(&s->stop, 0);
+        ctx->sampler = s;
+    }
+
+    plugin_sampler_stop(s);
+    s->trigger = trigger;
+    s->period = period;
+    plugin_register_cb_udata(id, QEMU_PLUGIN_EV_VCPU_SAMPLE, cb, udata);
+
+    if (cb && trigger == QEMU_PLUGIN_SAMPLE_HOST_TIME) {
+        s->running = true;
+        qemu_thread_create(&s->thread, "plugin-sampler",
+                           plugin_sampler_thread, s, QEMU_THREAD_JOINABLE);
+    }
+}
+
+/*
+ * The code cache must not reference the sampler anymore, see
+ * plugin_reset_uninstall.
+ */
+void plugin_sampler_free__locked(struct qemu_plugin_ctx *ctx)
+{
+    struct qemu_plugin_sampler *s = ctx->sampler;
+
+    if (s == NULL) {
+        return;
+    }
+    plugin_sampler_stop(s);
+    plugin_scoreboard_free(s->vcpus);
+    qemu_sem_destroy(&s->stop);
+    g_free(s);
+    ctx->sampler = NULL;
+}
+
+static void plugin_samplers_stop(void)
+{
+    struct qemu_plugin_ctx *ctx;
+
+    QEMU_LOCK_GUARD(&plugin.lock);
+    QTAILQ_FOREACH(ctx, &plugin.ctxs, entry) {
+        if (ctx->sampler) {
+            plugin_sampler_stop(ctx->sampler);
+        }
+    }
+}
+
 /*
  * Disable CFI checks.
  * The callback function has been loaded from an external library so we do not
@@ -478,6 +800,10 @@ void qemu_plugin_tb_trans_cb(CPUState *cpu, struct qemu_plugin_tb *tb)
 
     /* no plugin_state->event_mask check here; caller should have checked */
 
+    if (test_bit(QEMU_PLUGIN_EV_VCPU_SAMPLE, cpu->plugin_state->event_mask)) {
+        plugin_sample_tb_trans(tb);
+    }
+
     QLIST_FOREACH_SAFE_RCU(cb, &plugin.cb_lists[ev], entry, next) {
         qemu_plugin_vcpu_tb_trans_cb_t func = cb->f.vcpu_tb_trans;
 
@@ -501,6 +827,8 @@ qemu_plugin_vcpu_syscall(CPUState *cpu, int64_t num, uint64_t a1, uint64_t a2,
     struct qemu_plugin_cb *cb, *next;
     enum qemu_plugin_event ev = QEMU_PLUGIN_EV_VCPU_SYSCALL;
 
+    plugin_mem_buffers_flush(cpu->cpu_index);
+
     if (!test_bit(ev, cpu->plugin_state->event_mask)) {
         return;
     }
@@ -542,6 +870,7 @@ void qemu_plugin_vcpu_idle_cb(CPUState *cpu)
 {
     /* idle and resume cb may be called before init, ignore in this case */
     if (cpu->cpu_index < plugin.num_vcpus) {
+        plugin_mem_buffers_flush(cpu->cpu_index);
         qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_RW_REGS);
         plugin_vcpu_cb__simple(cpu, QEMU_PLUGIN_EV_VCPU_IDLE);
         qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_NO_REGS);
@@ -642,6 +971,12 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
                 qemu_plugin_set_cb_flags(cpu, QEMU_PLUGIN_CB_NO_REGS);
             }
             break;
+        case PLUGIN_CB_MEM_BUFFERED:
+            if (rw & cb->buffered.rw) {
+                plugin_mem_buffer_deliver(cpu->cpu_index, &cb->buffered,
+                                          make_plugin_meminfo(oi, rw), vaddr);
+            }
+            break;
         case PLUGIN_CB_INLINE_ADD_U64:
         case PLUGIN_CB_INLINE_STORE_U64:
             if (rw & cb->inline_insn.rw) {
@@ -656,6 +991,10 @@ void qemu_plugin_vcpu_mem_cb(CPUState *cpu, uint64_t vaddr,
 
 void qemu_plugin_atexit_cb(void)
 {
+    plugin_samplers_stop();
+    for (int i = 0; i < plugin.num_vcpus; i++) {
+        plugin_mem_buffers_flush(i);
+    }
     plugin_cb__udata(QEMU_PLUGIN_EV_ATEXIT);
 }
 
@@ -748,6 +1087,7 @@ static void __attribute__((__constructor__)) plugin_init(void)
     plugin.cpu_ht = g_hash_table_new(g_int_hash, g_int_equal);
     QLIST_INIT(&plugin.scoreboards);
     plugin.scoreboard_alloc_size = 16; /* avoid frequent reallocation */
+    QLIST_INIT(&plugin.mem_buffers);
     QTAILQ_INIT(&plugin.ctxs);
     qht_init(&plugin.dyn_cb_arr_ht, plugin_dyn_cb_arr_cmp, 16,
              QHT_MODE_AUTO_RESIZE);
@@ -783,6 +1123,60 @@ void plugin_scoreboard_free(struct qemu_plugin_scoreboard *score)
     g_free(score);
 }
 
+/*
+ * Keep enough room for all the inline accesses of one instruction, see
+ * plugin_gen_inject.
+ */
+#define PLUGIN_MEM_BUFFER_MIN_CAPACITY 256
+
+struct qemu_plugin_mem_buffer *
+plugin_mem_buffer_new(qemu_plugin_id_t id, size_t capacity,
+                      qemu_plugin_vcpu_mem_buffer_cb_t cb, void *udata)
+{
+    struct qemu_plugin_mem_buffer *buf =
+        g_new0(struct qemu_plugin_mem_buffer, 1);
+
+    buf->capacity = MAX(capacity, PLUGIN_MEM_BUFFER_MIN_CAPACITY);
+    buf->cb = cb;
+    buf->userp = udata;
+    buf->score = plugin_scoreboard_new(
+        sizeof(struct qemu_plugin_mem_buffer_slot) +
+        buf->capacity * sizeof(qemu_plugin_mem_record));
+
+    qemu_rec_mutex_lock(&plugin.lock);
+    buf->ctx = plugin_id_to_ctx_locked(id);
+    QLIST_INSERT_HEAD(&plugin.mem_buffers, buf, entry);
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    return buf;
+}
+
+void plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf)
+{
+    qemu_rec_mutex_lock(&plugin.lock);
+    QLIST_REMOVE(buf, entry);
+    qemu_rec_mutex_unlock(&plugin.lock);
+
+    plugin_scoreboard_free(buf->score);
+    g_free(buf);
+}
+
+/*
+ * Pending records are dropped: @ctx's callbacks may be about to be
+ * unloaded.  The code cache must not reference the buffers anymore, see
+ * plugin_reset_uninstall.
+ */
+void plugin_mem_buffers_free__locked(struct qemu_plugin_ctx *ctx)
+{
+    struct qemu_plugin_mem_buffer *buf, *next;
+
+    QLIST_FOREACH_SAFE(buf, &plugin.mem_buffers, entry, next) {
+        if (buf->ctx == ctx) {
+            plugin_mem_buffer_free(buf);
+        }
+    }
+}
+
 enum qemu_plugin_cb_flags tcg_call_to_qemu_plugin_cb_flags(int flags)
 {
     if (flags & TCG_CALL_NO_RWG) {
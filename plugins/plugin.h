@@ -34,6 +34,7 @@ struct qemu_plugin_state {
     GHashTable *cpu_ht;
     QLIST_HEAD(, qemu_plugin_scoreboard) scoreboards;
     size_t scoreboard_alloc_size;
+    QLIST_HEAD(, qemu_plugin_mem_buffer) mem_buffers;
     DECLARE_BITMAP(mask, QEMU_PLUGIN_EV_MAX);
     /*
      * @lock protects the struct as well as ctx->uninstalling.
@@ -62,11 +63,33 @@ struct qemu_plugin_ctx {
      * to strdup plugin args.
      */
     struct qemu_plugin_desc *desc;
+    struct qemu_plugin_sampler *sampler;
     bool installing;
     bool uninstalling;
     bool resetting;
 };
 
+/* Per-vCPU state of a sampler, kept in a scoreboard */
+struct qemu_plugin_sampler_vcpu {
+    /* instructions executed since the last sample */
+    uint64_t insns;
+    /* a host time sample is queued on the vCPU */
+    bool pending;
+};
+
+/* See qemu_plugin_register_vcpu_sample_cb() */
+struct qemu_plugin_sampler {
+    struct qemu_plugin_ctx *ctx;
+    enum qemu_plugin_sample_trigger trigger;
+    uint64_t period;
+    struct qemu_plugin_scoreboard *vcpus;
+    qemu_plugin_u64 insns;
+    /* host time samplers kick the vCPUs from @thread */
+    QemuThread thread;
+    QemuSemaphore stop;
+    bool running;
+};
+
 struct qemu_plugin_ctx *plugin_id_to_ctx_locked(qemu_plugin_id_t id);
 
 void plugin_register_inline_op_on_entry(GArray **arr,
@@ -109,6 +132,11 @@ void plugin_register_vcpu_mem_cb(GArray **arr,
                                  enum qemu_plugin_mem_rw rw,
                                  void *udata);
 
+void plugin_register_vcpu_mem_buffer(GArray **arr,
+                                     struct qemu_plugin_mem_buffer *buf,
+                                     enum qemu_plugin_mem_rw rw,
+                                     uint32_t tag);
+
 void exec_inline_op(enum plugin_dyn_cb_type type,
                     struct qemu_plugin_inline_cb *cb,
                     int cpu_index);
@@ -119,6 +147,16 @@ struct qemu_plugin_scoreboard *plugin_scoreboard_new(size_t element_size);
 
 void plugin_scoreboard_free(struct qemu_plugin_scoreboard *score);
 
+struct qemu_plugin_mem_buffer *
+plugin_mem_buffer_new(qemu_plugin_id_t id, size_t capacity,
+                      qemu_plugin_vcpu_mem_buffer_cb_t cb, void *udata);
+
+void plugin_mem_buffer_free(struct qemu_plugin_mem_buffer *buf);
+
+void plugin_mem_buffers_free__locked(struct qemu_plugin_ctx *ctx);
+
+void plugin_sampler_free__locked(struct qemu_plugin_ctx *ctx);
+
 /**
  * qemu_plugin_fillin_mode_info() - populate mode specific info
  * info: pointer to qemu_info_t structure
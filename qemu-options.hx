@@ -230,8 +230,12 @@ DEF("accel", HAS_ARG, QEMU_OPTION_accel,
     "                igd-passthru=on|off (enable Xen integrated Intel graphics passthrough, default=off)\n"
     "                kernel-irqchip=on|off|split controls accelerated irqchip support (default=on)\n"
     "                kvm-shadow-mem=size of KVM shadow MMU in bytes\n"
+    "                jmp-cache-bits=n (log2 of TCG per-vCPU jump cache entries, default 12)\n"
+    "                jmp-cache-grow=on|off (grow the TCG jump cache on a high miss rate)\n"
     "                one-insn-per-tb=on|off (one guest instruction per TCG translation block)\n"
+    "                prefetch=on|off (TCG translates likely successors while idle)\n"
     "                split-wx=on|off (enable TCG split w^x mapping)\n"
+    "                superblocks=on|off (TCG blocks continue past forward branches)\n"
     "                tb-size=n (TCG translation block cache size)\n"
     "                dirty-ring-size=n (KVM dirty ring GFN count, default 0)\n"
     "                eager-split-size=n (KVM Eager Page Split chunk size, default 0, disabled. ARM only)\n"
@@ -267,6 +271,31 @@ SRST
         can be useful in some situations, such as when trying to analyse
         the logs produced by the ``-d`` option.
 
+    ``jmp-cache-bits=n``
+        Sets the size of each vCPU's TCG jump cache, which maps guest
+        addresses to translation blocks before the global hash table is
+        consulted, to 2^n entries.  n ranges from 8 to 16; the default
+        is 12.
+
+    ``jmp-cache-grow=on|off``
+        Lets a vCPU's jump cache double in size, up to 2^14 entries,
+        whenever more than one in eight lookups miss over a window of
+        65536 lookups.  Hit and miss counts are reported by ``info jit``.
+        Disabled by default.
+
+    ``superblocks=on|off``
+        Lets the TCG accelerator keep translating past a forward
+        conditional branch, on the assumption that it is not taken,
+        instead of ending the translation block there.  The taken path
+        leaves through a side exit.  Only targets that implement it
+        (currently RISC-V) are affected.  Disabled by default.
+
+    ``prefetch=on|off``
+        Lets an idle vCPU thread translate the direct jump targets of
+        recently translated blocks ahead of time, so that they are
+        already in the translation cache when the guest wakes up.  Only
+        takes effect with ``thread=multi``.  Disabled by default.
+
     ``split-wx=on|off``
         Controls the use of split w^x mapping for the TCG code generation
         buffer. Some operating systems require this to be enabled, and in
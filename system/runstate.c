@@ -59,6 +59,7 @@
 #include "system/runstate-action.h"
 #include "system/system.h"
 #include "system/tpm.h"
+#include "tcg/perf.h"
 #include "trace.h"
 
 static NotifierList exit_notifiers =
@@ -980,6 +981,7 @@ void qemu_cleanup(int status)
     /* No more vcpu or device emulation activity beyond this point */
     vm_shutdown();
     replay_finish();
+    perf_exit();
 
     /*
      * We must cancel all block jobs while the block layer is drained,
@@ -411,6 +411,13 @@ struct CPUArchState {
      * address translation for the VS-stage page table walk.
      */
     bool two_stage_indirect_lookup;
+    /*
+     * Set when a superpage translated through satp was entered into the
+     * TLB in pieces that cputlb does not track as a large page (PMP
+     * granularity); an address-specific sfence.vma must then flush all
+     * satp modes.
+     */
+    bool tlb_split_superpage;
 
     uint32_t scounteren;
     uint32_t mcounteren;
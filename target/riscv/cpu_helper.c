@@ -1173,6 +1173,7 @@ static bool check_svukte_addr(CPURISCVState *env, vaddr addr)
  * @env: CPURISCVState
  * @physical: This will be set to the calculated physical address
  * @prot: The returned protection attributes
+ * @page_size: If not NULL, set to the size of the page mapping @addr
  * @addr: The virtual address or guest physical address to be translated
  * @fault_pte_addr: If not NULL, this will be set to fault pte address
  *                  when a error occurs on pte address translation.
@@ -1185,7 +1186,7 @@ static bool check_svukte_addr(CPURISCVState *env, vaddr addr)
  * @is_debug: Is this access from a debugger or the monitor?
  */
 static int get_physical_address(CPURISCVState *env, hwaddr *physical,
-                                int *ret_prot, vaddr addr,
+                                int *ret_prot, hwaddr *page_size, vaddr addr,
                                 target_ulong *fault_pte_addr,
                                 int access_type, int mmu_idx,
                                 bool first_stage, bool two_stage,
@@ -1207,6 +1208,10 @@ static int get_physical_address(CPURISCVState *env, hwaddr *physical,
     bool is_sstack_idx = ((mmu_idx & MMU_IDX_SS_WRITE) == MMU_IDX_SS_WRITE);
     bool sstack_page = false;
 
+    if (page_size) {
+        *page_size = TARGET_PAGE_SIZE;
+    }
+
     if (do_svukte_check(env, first_stage, mode, virt) &&
         !check_svukte_addr(env, addr)) {
         return TRANSLATE_FAIL;
@@ -1340,7 +1345,8 @@ static int get_physical_address(CPURISCVState *env, hwaddr *physical,
 
             /* Do the second stage translation on the base PTE address. */
             int vbase_ret = get_physical_address(env, &vbase, &vbase_prot,
-                                                 base, NULL, MMU_DATA_LOAD,
+                                                 NULL, base, NULL,
+                                                 MMU_DATA_LOAD,
                                                  MMUIdx_U, false, true,
                                                  is_debug, false);
 
@@ -1610,6 +1616,9 @@ static int get_physical_address(CPURISCVState *env, hwaddr *physical,
         prot &= ~PAGE_WRITE;
     }
     *ret_prot = prot;
+    if (page_size) {
+        *page_size = (hwaddr)1 << (PGSHIFT + ptshift);
+    }
 
     return TRANSLATE_SUCCESS;
 }
@@ -1665,14 +1674,15 @@ hwaddr riscv_cpu_get_phys_page_debug(CPUState *cs, vaddr addr)
     int prot;
     int mmu_idx = riscv_env_mmu_index(&cpu->env, false);
 
-    if (get_physical_address(env, &phys_addr, &prot, addr, NULL, 0, mmu_idx,
-                             true, env->virt_enabled, true, false)) {
+    if (get_physical_address(env, &phys_addr, &prot, NULL, addr, NULL, 0,
+                             mmu_idx, true, env->virt_enabled, true, false)) {
         return -1;
     }
 
     if (env->virt_enabled) {
-        if (get_physical_address(env, &phys_addr, &prot, phys_addr, NULL,
-                                 0, MMUIdx_U, false, true, true, false)) {
+        if (get_physical_address(env, &phys_addr, &prot, NULL, phys_addr,
+                                 NULL, 0, MMUIdx_U, false, true, true,
+                                 false)) {
             return -1;
         }
     }
@@ -1775,6 +1785,7 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     int mode = mmuidx_priv(mmu_idx);
     /* default TLB page size */
     hwaddr tlb_size = TARGET_PAGE_SIZE;
+    hwaddr page_size;
 
     env->guest_phys_fault_addr = 0;
 
@@ -1784,7 +1795,7 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     pmu_tlb_fill_incr_ctr(cpu, access_type);
     if (two_stage_lookup) {
         /* Two stage lookup */
-        ret = get_physical_address(env, &pa, &prot, address,
+        ret = get_physical_address(env, &pa, &prot, NULL, address,
                                    &env->guest_phys_fault_addr, access_type,
                                    mmu_idx, true, true, false, probe);
 
@@ -1807,9 +1818,9 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
             /* Second stage lookup */
             im_address = pa;
 
-            ret = get_physical_address(env, &pa, &prot2, im_address, NULL,
-                                       access_type, MMUIdx_U, false, true,
-                                       false, probe);
+            ret = get_physical_address(env, &pa, &prot2, NULL, im_address,
+                                       NULL, access_type, MMUIdx_U, false,
+                                       true, false, probe);
 
             qemu_log_mask(CPU_LOG_MMU,
                           "%s 2nd-stage address=%" VADDR_PRIx
@@ -1822,7 +1833,7 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
             if (ret == TRANSLATE_SUCCESS) {
                 ret = get_physical_address_pmp(env, &prot_pmp, pa,
                                                size, access_type, mode);
-                tlb_size = pmp_get_tlb_size(env, pa);
+                tlb_size = pmp_get_tlb_size(env, pa, TARGET_PAGE_SIZE);
 
                 qemu_log_mask(CPU_LOG_MMU,
                               "%s PMP address=" HWADDR_FMT_plx " ret %d prot"
@@ -1845,9 +1856,9 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
         }
     } else {
         /* Single stage lookup */
-        ret = get_physical_address(env, &pa, &prot, address, NULL,
-                                   access_type, mmu_idx, true, false, false,
-                                   probe);
+        ret = get_physical_address(env, &pa, &prot, &page_size, address,
+                                   NULL, access_type, mmu_idx, true, false,
+                                   false, probe);
 
         qemu_log_mask(CPU_LOG_MMU,
                       "%s address=%" VADDR_PRIx " ret %d physical "
@@ -1857,7 +1868,10 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
         if (ret == TRANSLATE_SUCCESS) {
             ret = get_physical_address_pmp(env, &prot_pmp, pa,
                                            size, access_type, mode);
-            tlb_size = pmp_get_tlb_size(env, pa);
+            tlb_size = pmp_get_tlb_size(env, pa, page_size);
+            if (tlb_size < page_size && page_size > TARGET_PAGE_SIZE) {
+                env->tlb_split_superpage = true;
+            }
 
             qemu_log_mask(CPU_LOG_MMU,
                           "%s PMP address=" HWADDR_FMT_plx " ret %d prot"
@@ -1873,8 +1887,10 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     }
 
     if (ret == TRANSLATE_SUCCESS) {
-        tlb_set_page(cs, address & ~(tlb_size - 1), pa & ~(tlb_size - 1),
-                     prot, mmu_idx, tlb_size);
+        /* A superpage is entered one TARGET_PAGE_SIZE page at a time. */
+        hwaddr mask = MIN(tlb_size, TARGET_PAGE_SIZE) - 1;
+
+        tlb_set_page(cs, address & ~mask, pa & ~mask, prot, mmu_idx, tlb_size);
         return true;
     } else if (probe) {
         return false;
@@ -1927,8 +1927,12 @@ static bool validate_vm(CPURISCVState *env, target_ulong vm)
     return vm <= satp_mode_supported_max && valid_vm[vm];
 }
 
+/*
+ * @idxmap names the MMU modes translated through the register; only
+ * those are flushed when it changes.
+ */
 static target_ulong legalize_xatp(CPURISCVState *env, target_ulong old_xatp,
-                                  target_ulong val)
+                                  target_ulong val, uint16_t idxmap)
 {
     target_ulong mask;
     bool vm;
@@ -1947,7 +1951,7 @@ static target_ulong legalize_xatp(CPURISCVState *env, target_ulong old_xatp,
          * performance.  Flushing the TLB on SATP writes with paging
          * enabled avoids leaking those invalid cached mappings.
          */
-        tlb_flush(env_cpu(env));
+        tlb_flush_by_mmuidx(env_cpu(env), idxmap);
         return val;
     }
     return old_xatp;
@@ -4351,7 +4355,7 @@ static RISCVException write_satp(CPURISCVState *env, int csrno,
         return RISCV_EXCP_NONE;
     }
 
-    env->satp = legalize_xatp(env, env->satp, val);
+    env->satp = legalize_xatp(env, env->satp, val, mmuidx_map_vma(false));
     return RISCV_EXCP_NONE;
 }
 
@@ -4960,7 +4964,7 @@ static RISCVException read_hgatp(CPURISCVState *env, int csrno,
 static RISCVException write_hgatp(CPURISCVState *env, int csrno,
                                   target_ulong val, uintptr_t ra)
 {
-    env->hgatp = legalize_xatp(env, env->hgatp, val);
+    env->hgatp = legalize_xatp(env, env->hgatp, val, mmuidx_map_vma(true));
     return RISCV_EXCP_NONE;
 }
 
@@ -5249,7 +5253,7 @@ static RISCVException read_vsatp(CPURISCVState *env, int csrno,
 static RISCVException write_vsatp(CPURISCVState *env, int csrno,
                                   target_ulong val, uintptr_t ra)
 {
-    env->vsatp = legalize_xatp(env, env->vsatp, val);
+    env->vsatp = legalize_xatp(env, env->vsatp, val, mmuidx_map_vma(true));
     return RISCV_EXCP_NONE;
 }
 
@@ -62,6 +62,23 @@ static inline bool mmuidx_2stage(int mmu_idx)
     return mmu_idx & MMU_2STAGE_BIT;
 }
 
+/*
+ * The MMU modes translated through satp (@virt false) or through
+ * vsatp and hgatp (@virt true).  M-mode accesses are never translated
+ * and are not affected by changes to either.
+ */
+static inline uint16_t mmuidx_map_vma(bool virt)
+{
+    uint16_t map = 0;
+
+    for (int i = 0; i < (MMU_IDX_SS_WRITE << 1); i++) {
+        if ((i & 3) != MMUIdx_M && mmuidx_2stage(i) == virt) {
+            map |= 1 << i;
+        }
+    }
+    return map;
+}
+
 /* share data between vector helpers and decode code */
 FIELD(VDATA, VM, 0, 1)
 FIELD(VDATA, LMUL, 1, 3)
@@ -28,6 +28,12 @@
 #include "exec/tlb-flags.h"
 #include "trace.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 
 //rd dst  rs1 src  rs2 grain_size
 void helper_dma(CPURISCVState *env,  target_ulong  rd, target_ulong  rs1, target_ulong rs2)
@@ -44,55 +50,372 @@ void helper_dma(CPURISCVState *env,  target_ulong  rd, target_ulong  rs1, target
     }
 }
 
-void helper_sort(CPURISCVState *env,  target_ulong  addr, target_ulong  array_num, target_ulong sort_num)
+/*
+ * G233 sort: sort @sort_num unsigned 32-bit words at @addr in place.
+ *
+ * The array is gathered into host memory one page-sized chunk at a time
+ * via probe_read(), sorted there and scattered back.  Chunks that do not
+ * resolve to host RAM (MMIO, watchpoints) fall back to per-word accesses.
+ * All faults are raised before the first store, and only words whose
+ * value changes are written back, so an already sorted array in a
+ * read-only page does not fault.
+ */
+static int g233_sort_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * Scratch space for the gathered array, allocated per call.  Faults
+ * unwind with siglongjmp() past the helper, so g233_sort_check() frees
+ * the buffer before raising one.  It is also remembered per thread so
+ * that anything else unwinding (a watchpoint, a failed MMIO access) only
+ * leaks it until the next call.
+ */
+static __thread uint32_t *g233_sort_buf;
+
+static uint32_t *g233_sort_alloc(size_t n)
+{
+    g_free(g233_sort_buf);
+    g233_sort_buf = n <= SIZE_MAX / (2 * sizeof(uint32_t)) ?
+                    g_try_new(uint32_t, 2 * n) : NULL;
+    return g233_sort_buf;
+}
+
+static void g233_sort_free(void)
+{
+    g_free(g233_sort_buf);
+    g233_sort_buf = NULL;
+}
+
+/*
+ * Number of whole words from @addr that fit in the current guest page,
+ * or 0 if the first word straddles a page boundary.
+ */
+static size_t g233_sort_chunk(target_ulong addr, size_t left)
 {
-    for(int i = 0; i < sort_num; i++){
-        int swap = 0;
-        for (int j = 0 ; j <sort_num -i -1; j++){
-            if( cpu_ldl_le_data(env, addr + j * 4) > cpu_ldl_le_data(env, addr + (j+1) * 4)){
-                uint32_t tmp = cpu_ldl_le_data(env, addr + j * 4);
-                cpu_stl_le_data(env, addr + j * 4, cpu_ldl_le_data(env, addr + (j+1) * 4));
-                cpu_stl_le_data(env, addr + (j+1) * 4, tmp);
-                swap = 1;
+    size_t room = -(addr | TARGET_PAGE_MASK) / sizeof(uint32_t);
+
+    return MIN(left, room);
+}
+
+static void g233_sort_probe(CPURISCVState *env, target_ulong addr, size_t cnt,
+                            MMUAccessType access_type, int mmu_idx,
+                            uintptr_t ra)
+{
+    if (cnt) {
+        probe_access(env, addr, cnt * 4, access_type, mmu_idx, ra);
+    } else {
+        probe_access(env, addr, 1, access_type, mmu_idx, ra);
+        probe_access(env, addr + 3, 1, access_type, mmu_idx, ra);
+    }
+}
+
+/*
+ * Check that @cnt words at @addr can be accessed without a fault.  If
+ * not, release the buffer and raise the fault.  Returns false if the
+ * fault did not happen after all; the caller then starts over with
+ * g233_sort_slow(), as nothing has been stored yet.
+ */
+static bool g233_sort_check(CPURISCVState *env, target_ulong addr, size_t cnt,
+                            MMUAccessType access_type, int mmu_idx,
+                            uintptr_t ra)
+{
+    void *host;
+    int flags;
+
+    if (cnt) {
+        flags = probe_access_flags(env, addr, cnt * 4, access_type, mmu_idx,
+                                   true, &host, ra);
+    } else {
+        flags = probe_access_flags(env, addr, 1, access_type, mmu_idx,
+                                   true, &host, ra) |
+                probe_access_flags(env, addr + 3, 1, access_type, mmu_idx,
+                                   true, &host, ra);
+    }
+    if (!(flags & TLB_INVALID_MASK)) {
+        return true;
+    }
+    g233_sort_free();
+    g233_sort_probe(env, addr, cnt, access_type, mmu_idx, ra);
+    return false;
+}
+
+/* Bubble sort in guest memory, only used if the buffer cannot be had. */
+static void g233_sort_slow(CPURISCVState *env, target_ulong addr,
+                           target_ulong sort_num, int mmu_idx, uintptr_t ra)
+{
+    for (target_ulong i = 0; i < sort_num; i++) {
+        bool swap = false;
+        for (target_ulong j = 0; j < sort_num - i - 1; j++) {
+            target_ulong a = addr + j * 4;
+            uint32_t x = cpu_ldl_le_mmuidx_ra(env, a, mmu_idx, ra);
+            uint32_t y = cpu_ldl_le_mmuidx_ra(env, a + 4, mmu_idx, ra);
+            if (x > y) {
+                cpu_stl_le_mmuidx_ra(env, a, y, mmu_idx, ra);
+                cpu_stl_le_mmuidx_ra(env, a + 4, x, mmu_idx, ra);
+                swap = true;
             }
         }
-        if(!swap){
+        if (!swap) {
             break;
         }
     }
 }
 
+void helper_sort(CPURISCVState *env,  target_ulong  addr, target_ulong  array_num, target_ulong sort_num)
+{
+    int mmu_idx = riscv_env_mmu_index(env, false);
+    uintptr_t ra = GETPC();
+    uint32_t *orig, *buf;
+    size_t i, n, cnt;
+    void *host;
+
+    if (sort_num < 2) {
+        return;
+    }
 
+    n = sort_num;
+    orig = n == sort_num ? g233_sort_alloc(n) : NULL;
+    if (!orig) {
+        g233_sort_slow(env, addr, sort_num, mmu_idx, ra);
+        return;
+    }
+    buf = orig + n;
 
-void helper_crush(CPURISCVState *env,  target_ulong  dst, target_ulong  src, target_ulong num)
+    /* Gather, raising any load fault in address order. */
+    for (i = 0; i < n; i += MAX(cnt, 1)) {
+        target_ulong a = addr + i * 4;
+
+        cnt = g233_sort_chunk(a, n - i);
+        if (!g233_sort_check(env, a, cnt, MMU_DATA_LOAD, mmu_idx, ra)) {
+            g233_sort_slow(env, addr, sort_num, mmu_idx, ra);
+            return;
+        }
+        host = cnt ? probe_read(env, a, cnt * 4, mmu_idx, ra) : NULL;
+        for (size_t k = 0; k < MAX(cnt, 1); k++) {
+            orig[i + k] = host ? ldl_le_p(host + k * 4) :
+                          cpu_ldl_le_mmuidx_ra(env, a + k * 4, mmu_idx, ra);
+        }
+    }
+
+    memcpy(buf, orig, n * sizeof(uint32_t));
+    qsort(buf, n, sizeof(uint32_t), g233_sort_cmp);
+
+    /* Raise any store fault before the array is modified. */
+    for (i = 0; i < n; i += MAX(cnt, 1)) {
+        target_ulong a = addr + i * 4;
+
+        cnt = g233_sort_chunk(a, n - i);
+        if (memcmp(orig + i, buf + i, MAX(cnt, 1) * 4) &&
+            !g233_sort_check(env, a, cnt, MMU_DATA_STORE, mmu_idx, ra)) {
+            g233_sort_slow(env, addr, sort_num, mmu_idx, ra);
+            return;
+        }
+    }
+
+    /* Scatter back only the words that changed. */
+    for (i = 0; i < n; i += MAX(cnt, 1)) {
+        target_ulong a = addr + i * 4;
+
+        cnt = g233_sort_chunk(a, n - i);
+        if (!memcmp(orig + i, buf + i, MAX(cnt, 1) * 4)) {
+            continue;
+        }
+        host = cnt ? probe_write(env, a, cnt * 4, mmu_idx, ra) : NULL;
+        for (size_t k = 0; k < MAX(cnt, 1); k++) {
+            if (orig[i + k] == buf[i + k]) {
+                continue;
+            }
+            if (host) {
+                stl_le_p(host + k * 4, buf[i + k]);
+            } else {
+                cpu_stl_le_mmuidx_ra(env, a + k * 4, buf[i + k], mmu_idx, ra);
+            }
+        }
+    }
+    g233_sort_free();
+}
+
+/*
+ * G233 crush/expand: pack the low nibbles of byte pairs into one byte,
+ * and split each byte into two nibble bytes.
+ *
+ * Both run over host memory one page-sized chunk at a time: the source
+ * and destination chunks are resolved with probe_read()/probe_write(),
+ * and converted with the widest kernel the host has.  Chunks that do not
+ * resolve to host RAM, units that straddle a page boundary and
+ * overlapping source/destination ranges fall back to byte accesses, which
+ * define the architectural result.
+ */
+typedef void G233NibbleHostFn(uint8_t *d, const uint8_t *s, size_t units);
+typedef void G233NibbleSlowFn(CPURISCVState *env, target_ulong d,
+                              target_ulong s, int mmu_idx, uintptr_t ra);
+
+static void g233_crush_host(uint8_t *d, const uint8_t *s, size_t units)
 {
-    int i = 0;
-    int j = 0;
-    while (i + 1 < num) {
-        uint8_t tmp = (cpu_ldl_le_data(env, src+ i * sizeof(uint8_t)) & 0x0F) | ((cpu_ldl_le_data(env, src+ (i + 1) * sizeof(uint8_t)) & 0x0F) <<4);
-        cpu_stl_le_data(env, dst + j * sizeof(uint8_t), tmp);
-        i += 2;
-        j++;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i nib = _mm_set1_epi8(0x0f);
+    const __m128i low = _mm_set1_epi16(0x00ff);
+
+    for (; i + 16 <= units; i += 16) {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((void *)(s + 2 * i)), nib);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((void *)(s + 2 * i + 16)),
+                                  nib);
+
+        a = _mm_and_si128(_mm_or_si128(a, _mm_srli_epi16(a, 4)), low);
+        b = _mm_and_si128(_mm_or_si128(b, _mm_srli_epi16(b, 4)), low);
+        _mm_storeu_si128((void *)(d + i), _mm_packus_epi16(a, b));
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    const uint8x16_t nib = vdupq_n_u8(0x0f);
+
+    for (; i + 16 <= units; i += 16) {
+        uint8x16x2_t v = vld2q_u8(s + 2 * i);
+
+        vst1q_u8(d + i, vorrq_u8(vandq_u8(v.val[0], nib),
+                                 vshlq_n_u8(v.val[1], 4)));
     }
+#endif
+
+    for (; i + 4 <= units; i += 4) {
+        uint64_t x = ldq_le_p(s + 2 * i) & 0x0f0f0f0f0f0f0f0full;
 
-    if (i < num) {
-        cpu_stl_le_data(env, dst + j * sizeof(uint8_t), (cpu_ldl_le_data(env, src+ i * sizeof(uint8_t)) & 0x0F));
-        j++;
+        x = (x | (x >> 4)) & 0x00ff00ff00ff00ffull;
+        x = (x | (x >> 8)) & 0x0000ffff0000ffffull;
+        x = (x | (x >> 16)) & 0x00000000ffffffffull;
+        stl_le_p(d + i, x);
+    }
+
+    for (; i < units; i++) {
+        d[i] = (s[2 * i] & 0x0f) | (s[2 * i + 1] << 4);
     }
 }
 
-void helper_expand(CPURISCVState *env,  target_ulong  dst, target_ulong  src, target_ulong num)
+static void g233_expand_host(uint8_t *d, const uint8_t *s, size_t units)
 {
-    size_t j = 0;
-    for (size_t i = 0; i < num; i++) {
-        cpu_stl_le_data(env, dst + j * sizeof(uint8_t), (cpu_ldl_le_data(env, src+ i * sizeof(uint8_t)) & 0x0F));
-        j += 1;
-        cpu_stl_le_data(env, dst + j * sizeof(uint8_t), ((cpu_ldl_le_data(env, src+ i * sizeof(uint8_t))>>4) & 0x0F));
-        j += 1;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i nib = _mm_set1_epi8(0x0f);
+
+    for (; i + 16 <= units; i += 16) {
+        __m128i v = _mm_loadu_si128((void *)(s + i));
+        __m128i lo = _mm_and_si128(v, nib);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nib);
+
+        _mm_storeu_si128((void *)(d + 2 * i), _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128((void *)(d + 2 * i + 16), _mm_unpackhi_epi8(lo, hi));
+    }
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    const uint8x16_t nib = vdupq_n_u8(0x0f);
+
+    for (; i + 16 <= units; i += 16) {
+        uint8x16_t v = vld1q_u8(s + i);
+        uint8x16x2_t r = { { vandq_u8(v, nib), vshrq_n_u8(v, 4) } };
+
+        vst2q_u8(d + 2 * i, r);
     }
+#endif
+
+    for (; i + 4 <= units; i += 4) {
+        uint64_t x = ldl_le_p(s + i);
+
+        x = (x | (x << 16)) & 0x0000ffff0000ffffull;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ffull;
+        x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0full;
+        stq_le_p(d + 2 * i, x);
+    }
+
+    for (; i < units; i++) {
+        d[2 * i] = s[i] & 0x0f;
+        d[2 * i + 1] = s[i] >> 4;
+    }
+}
+
+static void g233_crush_slow(CPURISCVState *env, target_ulong d,
+                            target_ulong s, int mmu_idx, uintptr_t ra)
+{
+    uint8_t lo = cpu_ldub_mmuidx_ra(env, s, mmu_idx, ra);
+    uint8_t hi = cpu_ldub_mmuidx_ra(env, s + 1, mmu_idx, ra);
+
+    cpu_stb_mmuidx_ra(env, d, (lo & 0x0f) | (hi << 4), mmu_idx, ra);
 }
 
+static void g233_expand_slow(CPURISCVState *env, target_ulong d,
+                             target_ulong s, int mmu_idx, uintptr_t ra)
+{
+    uint8_t v = cpu_ldub_mmuidx_ra(env, s, mmu_idx, ra);
 
+    cpu_stb_mmuidx_ra(env, d, v & 0x0f, mmu_idx, ra);
+    cpu_stb_mmuidx_ra(env, d + 1, v >> 4, mmu_idx, ra);
+}
+
+/*
+ * Convert @units units of @sunit source bytes into @dunit destination
+ * bytes each.
+ */
+static void g233_nibble_op(CPURISCVState *env, target_ulong dst,
+                           target_ulong src, target_ulong units,
+                           unsigned sunit, unsigned dunit,
+                           G233NibbleHostFn *host_fn,
+                           G233NibbleSlowFn *slow_fn, uintptr_t ra)
+{
+    int mmu_idx = riscv_env_mmu_index(env, false);
+    bool overlap = dst < src + units * sunit && src < dst + units * dunit;
+    target_ulong i, cnt;
+
+    for (i = 0; i < units; i += cnt) {
+        target_ulong s = src + i * sunit;
+        target_ulong d = dst + i * dunit;
+        target_ulong sroom = -(s | TARGET_PAGE_MASK) / sunit;
+        target_ulong droom = -(d | TARGET_PAGE_MASK) / dunit;
+        void *shost, *dhost;
+
+        cnt = MIN(units - i, MIN(sroom, droom));
+        if (overlap || cnt == 0) {
+            slow_fn(env, d, s, mmu_idx, ra);
+            cnt = 1;
+            continue;
+        }
+
+        shost = probe_read(env, s, cnt * sunit, mmu_idx, ra);
+        dhost = probe_write(env, d, cnt * dunit, mmu_idx, ra);
+        if (shost && dhost) {
+            host_fn(dhost, shost, cnt);
+        } else {
+            for (target_ulong k = 0; k < cnt; k++) {
+                slow_fn(env, d + k * dunit, s + k * sunit, mmu_idx, ra);
+            }
+        }
+    }
+}
+
+void helper_crush(CPURISCVState *env,  target_ulong  dst, target_ulong  src, target_ulong num)
+{
+    uintptr_t ra = GETPC();
+
+    g233_nibble_op(env, dst, src, num / 2, 2, 1,
+                   g233_crush_host, g233_crush_slow, ra);
+
+    if (num & 1) {
+        int mmu_idx = riscv_env_mmu_index(env, false);
+        uint8_t v = cpu_ldub_mmuidx_ra(env, src + num - 1, mmu_idx, ra);
+
+        cpu_stb_mmuidx_ra(env, dst + num / 2, v & 0x0f, mmu_idx, ra);
+    }
+}
+
+void helper_expand(CPURISCVState *env,  target_ulong  dst, target_ulong  src, target_ulong num)
+{
+    g233_nibble_op(env, dst, src, num, 1, 2,
+                   g233_expand_host, g233_expand_slow, GETPC());
+}
 
 /* Exceptions processing helpers */
 G_NORETURN void riscv_raise_exception(CPURISCVState *env,
@@ -621,18 +944,82 @@ void helper_wrs_nto(CPURISCVState *env)
     }
 }
 
-void helper_tlb_flush(CPURISCVState *env)
+static void check_sfence_vma(CPURISCVState *env, uintptr_t ra)
 {
-    CPUState *cs = env_cpu(env);
     if (!env->virt_enabled &&
         (env->priv == PRV_U ||
          (env->priv == PRV_S && get_field(env->mstatus, MSTATUS_TVM)))) {
-        riscv_raise_exception(env, RISCV_EXCP_ILLEGAL_INST, GETPC());
+        riscv_raise_exception(env, RISCV_EXCP_ILLEGAL_INST, ra);
     } else if (env->virt_enabled &&
                (env->priv == PRV_U || get_field(env->hstatus, HSTATUS_VTVM))) {
-        riscv_raise_exception(env, RISCV_EXCP_VIRT_INSTRUCTION_FAULT, GETPC());
-    } else {
-        tlb_flush(cs);
+        riscv_raise_exception(env, RISCV_EXCP_VIRT_INSTRUCTION_FAULT, ra);
+    }
+}
+
+/*
+ * Every write to satp (vsatp) that changes the ASID flushes the MMU
+ * modes it governs, so the TLB only ever holds translations for the
+ * current ASID and a fence for any other ASID has nothing to remove.
+ */
+static bool sfence_vma_asid_match(CPURISCVState *env, target_ulong asid)
+{
+    target_ulong atp = env->virt_enabled ? env->vsatp : env->satp;
+    target_ulong mask = riscv_cpu_mxl(env) == MXL_RV32 ? SATP32_ASID
+                                                        : SATP64_ASID;
+
+    return (atp & mask) == set_field(0, mask, asid);
+}
+
+/*
+ * cputlb tracks superpages that were entered whole, so flushing the page
+ * of @addr drops them too.  Guest superpages behind two-stage translation
+ * or split by PMP are entered one page at a time and are not tracked;
+ * flush all of the modes for those.
+ */
+static void sfence_vma_flush_page(CPURISCVState *env, target_ulong addr)
+{
+    unsigned bits = riscv_cpu_mxl(env) == MXL_RV32 ? 32 : TARGET_LONG_BITS;
+    uint16_t idxmap = mmuidx_map_vma(env->virt_enabled);
+
+    if (env->virt_enabled) {
+        tlb_flush_by_mmuidx(env_cpu(env), idxmap);
+        return;
+    }
+    if (env->tlb_split_superpage) {
+        env->tlb_split_superpage = false;
+        tlb_flush_by_mmuidx(env_cpu(env), idxmap);
+        return;
+    }
+    tlb_flush_range_by_mmuidx(env_cpu(env), addr & TARGET_PAGE_MASK,
+                              TARGET_PAGE_SIZE, idxmap, bits);
+}
+
+void helper_tlb_flush(CPURISCVState *env)
+{
+    check_sfence_vma(env, GETPC());
+    tlb_flush_by_mmuidx(env_cpu(env), mmuidx_map_vma(env->virt_enabled));
+}
+
+void helper_tlb_flush_page(CPURISCVState *env, target_ulong addr)
+{
+    check_sfence_vma(env, GETPC());
+    sfence_vma_flush_page(env, addr);
+}
+
+void helper_tlb_flush_asid(CPURISCVState *env, target_ulong asid)
+{
+    check_sfence_vma(env, GETPC());
+    if (sfence_vma_asid_match(env, asid)) {
+        tlb_flush_by_mmuidx(env_cpu(env), mmuidx_map_vma(env->virt_enabled));
+    }
+}
+
+void helper_tlb_flush_page_asid(CPURISCVState *env, target_ulong addr,
+                                target_ulong asid)
+{
+    check_sfence_vma(env, GETPC());
+    if (sfence_vma_asid_match(env, asid)) {
+        sfence_vma_flush_page(env, addr);
     }
 }
 
@@ -652,7 +1039,8 @@ void helper_hyp_tlb_flush(CPURISCVState *env)
 
     if (env->priv == PRV_M ||
         (env->priv == PRV_S && !env->virt_enabled)) {
-        tlb_flush(cs);
+        /* Only guest translations go through vsatp and hgatp. */
+        tlb_flush_by_mmuidx(cs, mmuidx_map_vma(true));
         return;
     }
 
@@ -661,23 +661,27 @@ target_ulong mseccfg_csr_read(CPURISCVState *env)
  * 0x80000008 bypass the check of PMP0.
  * To avoid this we return a size of 1 (which means no caching) if the PMP
  * region only covers partial of the TLB page.
+ *
+ * @size is the size of the (super)page that maps @addr, at least
+ * TARGET_PAGE_SIZE.  It is returned if the whole superpage has the same
+ * PMP permissions, so that it can be cached as one large page.
  */
-target_ulong pmp_get_tlb_size(CPURISCVState *env, hwaddr addr)
+target_ulong pmp_get_tlb_size(CPURISCVState *env, hwaddr addr, hwaddr size)
 {
     hwaddr pmp_sa;
     hwaddr pmp_ea;
-    hwaddr tlb_sa = addr & ~(TARGET_PAGE_SIZE - 1);
-    hwaddr tlb_ea = tlb_sa + TARGET_PAGE_SIZE - 1;
+    hwaddr tlb_sa = addr & ~(size - 1);
+    hwaddr tlb_ea = tlb_sa + size - 1;
     int i;
     uint8_t pmp_regions = riscv_cpu_cfg(env)->pmp_regions;
 
     /*
      * If PMP is not supported or there are no PMP rules, the TLB page will not
      * be split into regions with different permissions by PMP so we set the
-     * size to TARGET_PAGE_SIZE.
+     * size to that of the page.
      */
     if (!riscv_cpu_cfg(env)->pmp || !pmp_get_num_rules(env)) {
-        return TARGET_PAGE_SIZE;
+        return size;
     }
 
     for (i = 0; i < pmp_regions; i++) {
@@ -699,9 +703,13 @@ target_ulong pmp_get_tlb_size(CPURISCVState *env, hwaddr addr)
          * region of the page.
          */
         if (pmp_sa <= tlb_sa && pmp_ea >= tlb_ea) {
-            return TARGET_PAGE_SIZE;
+            return size;
         } else if ((pmp_sa >= tlb_sa && pmp_sa <= tlb_ea) ||
                    (pmp_ea >= tlb_sa && pmp_ea <= tlb_ea)) {
+            /* A superpage may still be cached a page at a time. */
+            if (size > TARGET_PAGE_SIZE) {
+                return pmp_get_tlb_size(env, addr, TARGET_PAGE_SIZE);
+            }
             return 1;
         }
     }
@@ -709,9 +717,9 @@ target_ulong pmp_get_tlb_size(CPURISCVState *env, hwaddr addr)
     /*
      * If no PMP entry matches the TLB page, the TLB page will also not be
      * split into regions with different permissions by PMP so we set the size
-     * to TARGET_PAGE_SIZE.
+     * to that of the page.
      */
-    return TARGET_PAGE_SIZE;
+    return size;
 }
 
 /*
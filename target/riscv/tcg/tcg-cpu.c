@@ -264,6 +264,7 @@ static vaddr riscv_pointer_wrap(CPUState *cs, int mmu_idx,
 
 const TCGCPUOps riscv_tcg_ops = {
     .mttcg_supported = true,
+    .large_page_refill = true,
     .guest_default_memory_order = 0,
 
     .initialize = riscv_translate_init,
@@ -53,6 +53,9 @@ typedef enum {
     EXT_ZERO,
 } DisasExtend;
 
+/* Forward branches a CF_TRACE block may translate past */
+#define RISCV_TRACE_MAX_SIDE_EXITS 4
+
 typedef struct DisasContext {
     DisasContextBase base;
     target_ulong cur_insn_len;
@@ -118,6 +121,18 @@ typedef struct DisasContext {
     bool fcfi_lp_expected;
     /* zicfiss extension, if shadow stack was enabled during TB gen */
     bool bcfi_enabled;
+    /* GPRs known to hold a translation-time constant within this TB. */
+    uint32_t gpr_const_mask;
+    target_long gpr_const[32];
+    /* goto_tb slots already emitted, each may only be used once */
+    uint8_t goto_tb_used;
+    /* CF_TRACE: taken paths of branches we translated past */
+    int nb_side_exits;
+    struct {
+        TCGLabel *label;
+        target_ulong dest;
+        target_ulong pc_save;
+    } side_exit[RISCV_TRACE_MAX_SIDE_EXITS];
 } DisasContext;
 
 static inline bool has_ext(DisasContext *ctx, uint32_t ext)
@@ -293,7 +308,9 @@ static void gen_goto_tb(DisasContext *ctx, int n, target_long diff)
       * Under itrigger, instruction executes one by one like singlestep,
       * direct block chain benefits will be small.
       */
-    if (translator_use_goto_tb(&ctx->base, dest) && !ctx->itrigger) {
+    if (translator_use_goto_tb(&ctx->base, dest) && !ctx->itrigger &&
+        !(ctx->goto_tb_used & (1 << n))) {
+        ctx->goto_tb_used |= 1 << n;
         /*
          * For pcrel, the pc must always be up-to-date on entry to
          * the linked TB, so that it can use simple additions for all
@@ -367,6 +384,29 @@ static TCGv get_gprh(DisasContext *ctx, int reg_num)
     return cpu_gprh[reg_num];
 }
 
+/*
+ * Every write to a GPR must go through gen_set_gpr*() (or call
+ * gpr_const_clear() itself) so that the known-constant tracking used by
+ * the G233 custom instructions stays correct.
+ */
+static void gpr_const_clear(DisasContext *ctx, int reg_num)
+{
+    ctx->gpr_const_mask &= ~(1u << reg_num);
+}
+
+static bool gpr_const_get(DisasContext *ctx, int reg_num, target_long *val)
+{
+    if (reg_num == 0) {
+        *val = 0;
+        return true;
+    }
+    if (ctx->gpr_const_mask & (1u << reg_num)) {
+        *val = ctx->gpr_const[reg_num];
+        return true;
+    }
+    return false;
+}
+
 static TCGv dest_gpr(DisasContext *ctx, int reg_num)
 {
     if (reg_num == 0 || get_olen(ctx) < TARGET_LONG_BITS) {
@@ -386,6 +426,7 @@ static TCGv dest_gprh(DisasContext *ctx, int reg_num)
 static void gen_set_gpr(DisasContext *ctx, int reg_num, TCGv t)
 {
     if (reg_num != 0) {
+        gpr_const_clear(ctx, reg_num);
         switch (get_ol(ctx)) {
         case MXL_RV32:
             tcg_gen_ext32s_tl(cpu_gpr[reg_num], t);
@@ -409,7 +450,8 @@ static void gen_set_gpri(DisasContext *ctx, int reg_num, target_long imm)
     if (reg_num != 0) {
         switch (get_ol(ctx)) {
         case MXL_RV32:
-            tcg_gen_movi_tl(cpu_gpr[reg_num], (int32_t)imm);
+            imm = (int32_t)imm;
+            tcg_gen_movi_tl(cpu_gpr[reg_num], imm);
             break;
         case MXL_RV64:
         case MXL_RV128:
@@ -418,6 +460,8 @@ static void gen_set_gpri(DisasContext *ctx, int reg_num, target_long imm)
         default:
             g_assert_not_reached();
         }
+        ctx->gpr_const_mask |= 1u << reg_num;
+        ctx->gpr_const[reg_num] = imm;
 
         if (get_xl_max(ctx) == MXL_RV128) {
             tcg_gen_movi_tl(cpu_gprh[reg_num], -(imm < 0));
@@ -429,6 +473,7 @@ static void gen_set_gpr128(DisasContext *ctx, int reg_num, TCGv rl, TCGv rh)
 {
     assert(get_ol(ctx) == MXL_RV128);
     if (reg_num != 0) {
+        gpr_const_clear(ctx, reg_num);
         tcg_gen_mov_tl(cpu_gpr[reg_num], rl);
         tcg_gen_mov_tl(cpu_gprh[reg_num], rh);
     }
@@ -516,6 +561,7 @@ static void gen_set_fpr_hs(DisasContext *ctx, int reg_num, TCGv_i64 t)
         return;
     }
     if (reg_num != 0) {
+        gpr_const_clear(ctx, reg_num);
         switch (get_xl(ctx)) {
         case MXL_RV32:
 #ifdef TARGET_RISCV32
@@ -541,6 +587,8 @@ static void gen_set_fpr_d(DisasContext *ctx, int reg_num, TCGv_i64 t)
     }
 
     if (reg_num != 0) {
+        gpr_const_clear(ctx, reg_num);
+        gpr_const_clear(ctx, reg_num + 1);
         switch (get_xl(ctx)) {
         case MXL_RV32:
 #ifdef TARGET_RISCV32
@@ -1173,6 +1221,7 @@ static uint32_t opcode_at(DisasContextBase *dcbase, target_ulong pc)
 
 /* Include insn module translation function */
 #include "insn_trans/trans_rvi.c.inc"
+#include "insn_trans/trans_rvg233.c.inc"
 #include "insn_trans/trans_rvm.c.inc"
 #include "insn_trans/trans_rva.c.inc"
 #include "insn_trans/trans_rvf.c.inc"
@@ -1315,6 +1364,9 @@ static void riscv_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cs)
     ctx->ztso = cpu->cfg.ext_ztso;
     ctx->itrigger = FIELD_EX32(tb_flags, TB_FLAGS, ITRIGGER);
     ctx->bcfi_enabled = FIELD_EX32(tb_flags, TB_FLAGS, BCFI_ENABLED);
+    ctx->gpr_const_mask = 0;
+    ctx->goto_tb_used = 0;
+    ctx->nb_side_exits = 0;
     ctx->fcfi_lp_expected = FIELD_EX32(tb_flags, TB_FLAGS, FCFI_LP_EXPECTED);
     ctx->fcfi_enabled = FIELD_EX32(tb_flags, TB_FLAGS, FCFI_ENABLED);
     ctx->zero = tcg_constant_tl(0);
@@ -1398,6 +1450,18 @@ static void riscv_tr_tb_stop(DisasContextBase *dcbase, CPUState *cpu)
     default:
         g_assert_not_reached();
     }
+
+    /*
+     * Side exits of a CF_TRACE block, with cpu_pc as it was at the
+     * branch.  They take whichever goto_tb slot the block end left free.
+     */
+    for (int i = 0; i < ctx->nb_side_exits; i++) {
+        int n = ctx->goto_tb_used & (1 << 1) ? 0 : 1;
+
+        gen_set_label(ctx->side_exit[i].label);
+        ctx->pc_save = ctx->side_exit[i].pc_save;
+        gen_goto_tb(ctx, n, ctx->side_exit[i].dest - ctx->base.pc_next);
+    }
 }
 
 static const TranslatorOps riscv_tr_ops = {
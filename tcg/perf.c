@@ -9,6 +9,7 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/units.h"
 #include "elf.h"
 #include "exec/target_page.h"
 #include "exec/translation-block.h"
@@ -44,7 +45,20 @@ static FILE *safe_fopen_w(const char *path)
     return f;
 }
 
+/*
+ * perf-<pid>.map has no notion of time: perf attributes every sample to
+ * the last entry covering its address. The file therefore only describes
+ * the code since the last reset of the code buffer, see perf_report_reset,
+ * and stops growing at PERFMAP_MAX_SIZE until the next reset.
+ */
+#define PERFMAP_MAX_SIZE (64 * MiB)
+
 static FILE *perfmap;
+/* Bytes written since the last reset; asking stdio would cost a syscall */
+static size_t perfmap_size;
+static bool perfmap_full;
+static const void *prologue_start;
+static size_t prologue_size;
 
 void perf_enable_perfmap(void)
 {
@@ -99,6 +113,13 @@ static const char *pretty_symbol(const struct debuginfo_query *q, size_t *len)
     return buf;
 }
 
+static void perfmap_account(int written)
+{
+    if (written > 0) {
+        perfmap_size += written;
+    }
+}
+
 static void write_perfmap_entry(const void *start, size_t insn,
                                 const struct debuginfo_query *q)
 {
@@ -106,8 +127,8 @@ static void write_perfmap_entry(const void *start, size_t insn,
     uintptr_t host_pc;
 
     get_host_pc_size(&host_pc, &host_size, start, insn);
-    fprintf(perfmap, "%"PRIxPTR" %"PRIx16" %s\n",
-            host_pc, host_size, pretty_symbol(q, NULL));
+    perfmap_account(fprintf(perfmap, "%"PRIxPTR" %"PRIx16" %s\n",
+                            host_pc, host_size, pretty_symbol(q, NULL)));
 }
 
 static FILE *jitdump;
@@ -131,6 +152,7 @@ struct jitheader {
 enum jit_record_type {
     JIT_CODE_LOAD = 0,
     JIT_CODE_DEBUG_INFO = 2,
+    JIT_CODE_CLOSE = 3,
 };
 
 struct jr_prefix {
@@ -233,11 +255,18 @@ void perf_enable_jitdump(void)
     fwrite(&header, sizeof(header), 1, jitdump);
 }
 
+static void write_perfmap_prologue(void)
+{
+    perfmap_account(fprintf(perfmap, "%"PRIxPTR" %zx tcg-prologue-buffer\n",
+                            (uintptr_t)prologue_start, prologue_size));
+}
+
 void perf_report_prologue(const void *start, size_t size)
 {
+    prologue_start = start;
+    prologue_size = size;
     if (perfmap) {
-        fprintf(perfmap, "%"PRIxPTR" %zx tcg-prologue-buffer\n",
-                (uintptr_t)start, size);
+        write_perfmap_prologue();
     }
 }
 
@@ -343,8 +372,16 @@ void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
     /* Emit perfmap entries if needed. */
     if (perfmap) {
         flockfile(perfmap);
-        for (insn = 0; insn < tb->icount; insn++) {
-            write_perfmap_entry(start, insn, &q[insn]);
+        if (!perfmap_full && perfmap_size >= PERFMAP_MAX_SIZE) {
+            warn_report_once("perf map reached %d MiB, not adding entries "
+                             "until the code buffer is flushed",
+                             PERFMAP_MAX_SIZE / MiB);
+            perfmap_full = true;
+        }
+        if (!perfmap_full) {
+            for (insn = 0; insn < tb->icount; insn++) {
+                write_perfmap_entry(start, insn, &q[insn]);
+            }
         }
         funlockfile(perfmap);
     }
@@ -362,6 +399,40 @@ void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
     g_free(q);
 }
 
+/*
+ * The code buffer is being reset and its contents will be overwritten.
+ * Jitdump needs nothing here: each JIT_CODE_LOAD is timestamped and perf
+ * lets the newest load win for the addresses it covers. The perf map,
+ * however, would keep the stale entries forever, so start it over.
+ */
+void perf_report_reset(void)
+{
+    if (perfmap) {
+        flockfile(perfmap);
+        rewind(perfmap);
+        if (ftruncate(fileno(perfmap), 0) == 0) {
+            perfmap_size = 0;
+            perfmap_full = false;
+            write_perfmap_prologue();
+        } else {
+            warn_report_once("Could not truncate perf map: %s",
+                             strerror(errno));
+        }
+        funlockfile(perfmap);
+    }
+}
+
+/* Write a JIT_CODE_CLOSE jitdump entry. */
+static void write_jr_code_close(void)
+{
+    struct jr_prefix rec;
+
+    rec.id = JIT_CODE_CLOSE;
+    rec.total_size = sizeof(rec);
+    rec.timestamp = get_clock();
+    fwrite(&rec, sizeof(rec), 1, jitdump);
+}
+
 void perf_exit(void)
 {
     if (perfmap) {
@@ -375,6 +446,7 @@ void perf_exit(void)
     }
 
     if (jitdump) {
+        write_jr_code_close();
         fclose(jitdump);
         jitdump = NULL;
     }
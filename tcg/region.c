@@ -31,6 +31,7 @@
 #include "qemu/qtree.h"
 #include "qapi/error.h"
 #include "tcg/tcg.h"
+#include "tcg/perf.h"
 #include "exec/translation-block.h"
 #include "tcg-internal.h"
 #include "host/cpuinfo.h"
@@ -420,6 +421,7 @@ void tcg_region_reset_all(void)
     qemu_mutex_unlock(&region.lock);
 
     tcg_region_tree_reset_all();
+    perf_report_reset();
 }
 
 static size_t tcg_n_regions(size_t tb_size, unsigned max_threads)
@@ -4660,6 +4660,26 @@ static void set_temp_val_nonreg(TCGContext *s, TCGTemp *ts, TCGTempVal type)
 
 static void temp_load(TCGContext *, TCGTemp *, TCGRegSet, TCGRegSet, TCGRegSet);
 
+/* Statistics are only written by the owning thread. */
+static inline void tcg_ra_count(size_t *counter)
+{
+    qatomic_set(counter, *counter + 1);
+}
+
+void tcg_reg_alloc_stats(size_t *stores, size_t *spills, size_t *reloads)
+{
+    unsigned int n_ctxs = qatomic_read(&tcg_cur_ctxs);
+
+    *stores = *spills = *reloads = 0;
+    for (unsigned int i = 0; i < n_ctxs; i++) {
+        const TCGContext *s = qatomic_read(&tcg_ctxs[i]);
+
+        *stores += qatomic_read(&s->ra_store_count);
+        *spills += qatomic_read(&s->ra_spill_count);
+        *reloads += qatomic_read(&s->ra_reload_count);
+    }
+}
+
 /* Mark a temporary as free or dead.  If 'free_or_dead' is negative,
    mark it free; otherwise mark it dead.  */
 static void temp_free_or_dead(TCGContext *s, TCGTemp *ts, int free_or_dead)
@@ -4710,6 +4730,7 @@ static void temp_sync(TCGContext *s, TCGTemp *ts, TCGRegSet allocated_regs,
             if (free_or_dead
                 && tcg_out_sti(s, ts->type, ts->val,
                                ts->mem_base->reg, ts->mem_offset)) {
+                tcg_ra_count(&s->ra_store_count);
                 break;
             }
             temp_load(s, ts, tcg_target_available_regs[ts->type],
@@ -4719,6 +4740,7 @@ static void temp_sync(TCGContext *s, TCGTemp *ts, TCGRegSet allocated_regs,
         case TEMP_VAL_REG:
             tcg_out_st(s, ts->type, ts->reg,
                        ts->mem_base->reg, ts->mem_offset);
+            tcg_ra_count(&s->ra_store_count);
             break;
 
         case TEMP_VAL_MEM:
@@ -4740,6 +4762,9 @@ static void tcg_reg_free(TCGContext *s, TCGReg reg, TCGRegSet allocated_regs)
 {
     TCGTemp *ts = s->reg_to_temp[reg];
     if (ts != NULL) {
+        if (!temp_readonly(ts) && !ts->mem_coherent) {
+            tcg_ra_count(&s->ra_spill_count);
+        }
         temp_sync(s, ts, allocated_regs, 0, -1);
     }
 }
@@ -4905,6 +4930,7 @@ static void temp_load(TCGContext *s, TCGTemp *ts, TCGRegSet desired_regs,
         reg = tcg_reg_alloc(s, desired_regs, allocated_regs,
                             preferred_regs, ts->indirect_base);
         tcg_out_ld(s, ts->type, reg, ts->mem_base->reg, ts->mem_offset);
+        tcg_ra_count(&s->ra_reload_count);
         ts->mem_coherent = 1;
         break;
     case TEMP_VAL_DEAD:
@@ -69,7 +69,7 @@ static uint64_t tci_uint64(uint32_t high, uint32_t low)
  *   m = immediate (MemOpIdx)
  *   n = immediate (call return length)
  *   r = register
- *   s = signed ldst offset
+ *   s = signed ldst offset or addend
  */
 
 static void tci_args_l(uint32_t insn, const void *tb_ptr, void **l0)
@@ -109,6 +109,17 @@ static void tci_args_ri(uint32_t insn, TCGReg *r0, tcg_target_ulong *i1)
     *i1 = sextract32(insn, 12, 20);
 }
 
+static void tci_args_rrcl(uint32_t insn, const uint32_t **tb_ptr,
+                          TCGReg *r0, TCGReg *r1, TCGCond *c2, void **l3)
+{
+    int32_t diff = *(*tb_ptr)++;
+
+    *r0 = extract32(insn, 8, 4);
+    *r1 = extract32(insn, 12, 4);
+    *c2 = extract32(insn, 16, 4);
+    *l3 = (void *)*tb_ptr + diff;
+}
+
 static void tci_args_rrm(uint32_t insn, TCGReg *r0,
                          TCGReg *r1, MemOpIdx *m2)
 {
@@ -325,6 +336,23 @@ static void tci_qemu_st(CPUArchState *env, uint64_t taddr, uint64_t val,
     }
 }
 
+/*
+ * Threaded dispatch: the opcodes executed most often get a label of
+ * their own and end by fetching the next instruction and jumping
+ * straight to its handler.  Each of them thus has its own indirect
+ * branch, which the host predicts far better than the single one at
+ * the top of the switch.  All other opcodes go through tci_switch.
+ */
+#define TCI_CASE(name) \
+    case INDEX_op_##name: tci_op_##name
+
+#define TCI_NEXT                                \
+    do {                                        \
+        insn = *tb_ptr++;                       \
+        opc = extract32(insn, 0, 8);            \
+        goto *tci_dispatch[opc];                \
+    } while (0)
+
 /* Interpret pseudo code in tb. */
 /*
  * Disable CFI checks.
@@ -339,6 +367,34 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
     uint64_t stack[(TCG_STATIC_CALL_ARGS_SIZE + TCG_STATIC_FRAME_SIZE)
                    / sizeof(uint64_t)];
     bool carry = false;
+    static const void * const tci_dispatch[NB_OPS] = {
+        [0 ... NB_OPS - 1] = &&tci_switch,
+        [INDEX_op_call] = &&tci_op_call,
+        [INDEX_op_br] = &&tci_op_br,
+        [INDEX_op_mov] = &&tci_op_mov,
+        [INDEX_op_tci_movi] = &&tci_op_tci_movi,
+        [INDEX_op_ld] = &&tci_op_ld,
+        [INDEX_op_st] = &&tci_op_st,
+        [INDEX_op_add] = &&tci_op_add,
+        [INDEX_op_tci_addi] = &&tci_op_tci_addi,
+        [INDEX_op_sub] = &&tci_op_sub,
+        [INDEX_op_and] = &&tci_op_and,
+        [INDEX_op_or] = &&tci_op_or,
+        [INDEX_op_xor] = &&tci_op_xor,
+        [INDEX_op_shl] = &&tci_op_shl,
+        [INDEX_op_shr] = &&tci_op_shr,
+        [INDEX_op_sar] = &&tci_op_sar,
+        [INDEX_op_extract] = &&tci_op_extract,
+        [INDEX_op_brcond] = &&tci_op_brcond,
+        [INDEX_op_tci_brcond] = &&tci_op_tci_brcond,
+        [INDEX_op_tci_brcond32] = &&tci_op_tci_brcond32,
+        [INDEX_op_tci_setcond32] = &&tci_op_tci_setcond32,
+        [INDEX_op_exit_tb] = &&tci_op_exit_tb,
+        [INDEX_op_goto_tb] = &&tci_op_goto_tb,
+        [INDEX_op_goto_ptr] = &&tci_op_goto_ptr,
+        [INDEX_op_qemu_ld] = &&tci_op_qemu_ld,
+        [INDEX_op_qemu_st] = &&tci_op_qemu_st,
+    };
 
     regs[TCG_AREG0] = (tcg_target_ulong)env;
     regs[TCG_REG_CALL_STACK] = (uintptr_t)stack;
@@ -359,9 +415,11 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
 
         insn = *tb_ptr++;
         opc = extract32(insn, 0, 8);
+        goto *tci_dispatch[opc];
 
+    tci_switch:
         switch (opc) {
-        case INDEX_op_call:
+        TCI_CASE(call):
             {
                 void *call_slots[MAX_CALL_IARGS];
                 ffi_cif *cif;
@@ -412,12 +470,12 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             default:
                 g_assert_not_reached();
             }
-            break;
+            TCI_NEXT;
 
-        case INDEX_op_br:
+        TCI_CASE(br):
             tci_args_l(insn, tb_ptr, &ptr);
             tb_ptr = ptr;
-            continue;
+            TCI_NEXT;
 #if TCG_TARGET_REG_BITS == 32
         case INDEX_op_setcond2_i32:
             tci_args_rrrrrc(insn, &r0, &r1, &r2, &r3, &r4, &condition);
@@ -436,14 +494,14 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             regs[r0] = regs[tmp32 ? r3 : r4];
             break;
 #endif
-        case INDEX_op_mov:
+        TCI_CASE(mov):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = regs[r1];
-            break;
-        case INDEX_op_tci_movi:
+            TCI_NEXT;
+        TCI_CASE(tci_movi):
             tci_args_ri(insn, &r0, &t1);
             regs[r0] = t1;
-            break;
+            TCI_NEXT;
         case INDEX_op_tci_movl:
             tci_args_rl(insn, tb_ptr, &r0, &ptr);
             regs[r0] = *(tcg_target_ulong *)ptr;
@@ -474,11 +532,11 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int16_t *)ptr;
             break;
-        case INDEX_op_ld:
+        TCI_CASE(ld):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(tcg_target_ulong *)ptr;
-            break;
+            TCI_NEXT;
         case INDEX_op_st8:
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
@@ -489,38 +547,42 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             ptr = (void *)(regs[r1] + ofs);
             *(uint16_t *)ptr = regs[r0];
             break;
-        case INDEX_op_st:
+        TCI_CASE(st):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(tcg_target_ulong *)ptr = regs[r0];
-            break;
+            TCI_NEXT;
 
             /* Arithmetic operations (mixed 32/64 bit). */
 
-        case INDEX_op_add:
+        TCI_CASE(add):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] + regs[r2];
-            break;
-        case INDEX_op_sub:
+            TCI_NEXT;
+        TCI_CASE(tci_addi):
+            tci_args_rrs(insn, &r0, &r1, &ofs);
+            regs[r0] = regs[r1] + ofs;
+            TCI_NEXT;
+        TCI_CASE(sub):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] - regs[r2];
-            break;
+            TCI_NEXT;
         case INDEX_op_mul:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] * regs[r2];
             break;
-        case INDEX_op_and:
+        TCI_CASE(and):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] & regs[r2];
-            break;
-        case INDEX_op_or:
+            TCI_NEXT;
+        TCI_CASE(or):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] | regs[r2];
-            break;
-        case INDEX_op_xor:
+            TCI_NEXT;
+        TCI_CASE(xor):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] ^ regs[r2];
-            break;
+            TCI_NEXT;
         case INDEX_op_andc:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] & ~regs[r2];
@@ -640,10 +702,10 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             tmp32 = regs[r1];
             regs[r0] = tmp32 ? ctz32(tmp32) : regs[r2];
             break;
-        case INDEX_op_tci_setcond32:
+        TCI_CASE(tci_setcond32):
             tci_args_rrrc(insn, &r0, &r1, &r2, &condition);
             regs[r0] = tci_compare32(regs[r1], regs[r2], condition);
-            break;
+            TCI_NEXT;
         case INDEX_op_tci_movcond32:
             tci_args_rrrrrc(insn, &r0, &r1, &r2, &r3, &r4, &condition);
             tmp32 = tci_compare32(regs[r1], regs[r2], condition);
@@ -652,19 +714,19 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
 
             /* Shift/rotate operations. */
 
-        case INDEX_op_shl:
+        TCI_CASE(shl):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] << (regs[r2] % TCG_TARGET_REG_BITS);
-            break;
-        case INDEX_op_shr:
+            TCI_NEXT;
+        TCI_CASE(shr):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] >> (regs[r2] % TCG_TARGET_REG_BITS);
-            break;
-        case INDEX_op_sar:
+            TCI_NEXT;
+        TCI_CASE(sar):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ((tcg_target_long)regs[r1]
                         >> (regs[r2] % TCG_TARGET_REG_BITS));
-            break;
+            TCI_NEXT;
         case INDEX_op_tci_rotl32:
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = rol32(regs[r1], regs[r2] & 31);
@@ -677,20 +739,32 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             tci_args_rrrbb(insn, &r0, &r1, &r2, &pos, &len);
             regs[r0] = deposit_tr(regs[r1], pos, len, regs[r2]);
             break;
-        case INDEX_op_extract:
+        TCI_CASE(extract):
             tci_args_rrbb(insn, &r0, &r1, &pos, &len);
             regs[r0] = extract_tr(regs[r1], pos, len);
-            break;
+            TCI_NEXT;
         case INDEX_op_sextract:
             tci_args_rrbb(insn, &r0, &r1, &pos, &len);
             regs[r0] = sextract_tr(regs[r1], pos, len);
             break;
-        case INDEX_op_brcond:
+        TCI_CASE(brcond):
             tci_args_rl(insn, tb_ptr, &r0, &ptr);
             if (regs[r0]) {
                 tb_ptr = ptr;
             }
-            break;
+            TCI_NEXT;
+        TCI_CASE(tci_brcond):
+            tci_args_rrcl(insn, &tb_ptr, &r0, &r1, &condition, &ptr);
+            if (tci_compare64(regs[r0], regs[r1], condition)) {
+                tb_ptr = ptr;
+            }
+            TCI_NEXT;
+        TCI_CASE(tci_brcond32):
+            tci_args_rrcl(insn, &tb_ptr, &r0, &r1, &condition, &ptr);
+            if (tci_compare32(regs[r0], regs[r1], condition)) {
+                tb_ptr = ptr;
+            }
+            TCI_NEXT;
         case INDEX_op_bswap16:
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = bswap16(regs[r1]);
@@ -771,35 +845,35 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
 
             /* QEMU specific operations. */
 
-        case INDEX_op_exit_tb:
+        TCI_CASE(exit_tb):
             tci_args_l(insn, tb_ptr, &ptr);
             return (uintptr_t)ptr;
 
-        case INDEX_op_goto_tb:
+        TCI_CASE(goto_tb):
             tci_args_l(insn, tb_ptr, &ptr);
             tb_ptr = *(void **)ptr;
-            break;
+            TCI_NEXT;
 
-        case INDEX_op_goto_ptr:
+        TCI_CASE(goto_ptr):
             tci_args_r(insn, &r0);
             ptr = (void *)regs[r0];
             if (!ptr) {
                 return 0;
             }
             tb_ptr = ptr;
-            break;
+            TCI_NEXT;
 
-        case INDEX_op_qemu_ld:
+        TCI_CASE(qemu_ld):
             tci_args_rrm(insn, &r0, &r1, &oi);
             taddr = regs[r1];
             regs[r0] = tci_qemu_ld(env, taddr, oi, tb_ptr);
-            break;
+            TCI_NEXT;
 
-        case INDEX_op_qemu_st:
+        TCI_CASE(qemu_st):
             tci_args_rrm(insn, &r0, &r1, &oi);
             taddr = regs[r1];
             tci_qemu_st(env, taddr, regs[r0], oi, tb_ptr);
-            break;
+            TCI_NEXT;
 
         case INDEX_op_qemu_ld2:
             tcg_debug_assert(TCG_TARGET_REG_BITS == 32);
@@ -920,6 +994,14 @@ int print_insn_tci(bfd_vma addr, disassemble_info *info)
                            op_name, str_r(r0), ptr);
         break;
 
+    case INDEX_op_tci_brcond:
+    case INDEX_op_tci_brcond32:
+        tci_args_rrcl(insn, &tb_ptr, &r0, &r1, &c, &ptr);
+        info->fprintf_func(info->stream, "%-12s  %s, %s, %s, %p",
+                           op_name, str_r(r0), str_r(r1), str_c(c), ptr);
+        /* The displacement occupies a second word. */
+        return 2 * sizeof(insn);
+
     case INDEX_op_setcond:
     case INDEX_op_tci_setcond32:
         tci_args_rrrc(insn, &r0, &r1, &r2, &c);
@@ -953,6 +1035,7 @@ int print_insn_tci(bfd_vma addr, disassemble_info *info)
     case INDEX_op_st16:
     case INDEX_op_st32:
     case INDEX_op_st:
+    case INDEX_op_tci_addi:
         tci_args_rrs(insn, &r0, &r1, &s2);
         info->fprintf_func(info->stream, "%-12s  %s, %s, %d",
                            op_name, str_r(r0), str_r(r1), s2);
@@ -0,0 +1,134 @@
+/*
+ * QEMU gvec acceleration speed benchmark
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.  See the COPYING file in the
+ * top-level directory.
+ */
+#include "qemu/osdep.h"
+#include "qemu/gvec-accel.h"
+#include "qemu/units.h"
+
+/* Guest vector sizes, up to a 2048-bit SVE register. */
+static const intptr_t sizes[] = { 64, 128, 256 };
+
+static const char * const op_names[GVEC_ACCEL_NB_OPS] = {
+    [GVEC_ACCEL_ADD8] = "add8",
+    [GVEC_ACCEL_ADD16] = "add16",
+    [GVEC_ACCEL_ADD32] = "add32",
+    [GVEC_ACCEL_ADD64] = "add64",
+    [GVEC_ACCEL_SUB8] = "sub8",
+    [GVEC_ACCEL_SUB16] = "sub16",
+    [GVEC_ACCEL_SUB32] = "sub32",
+    [GVEC_ACCEL_SUB64] = "sub64",
+    [GVEC_ACCEL_AND] = "and",
+    [GVEC_ACCEL_OR] = "or",
+    [GVEC_ACCEL_XOR] = "xor",
+    [GVEC_ACCEL_ANDC] = "andc",
+};
+
+#define DO_LOOP(TYPE, EXPR)                                     \
+    for (; i < oprsz; i += sizeof(TYPE)) {                      \
+        TYPE x = *(TYPE *)(a + i), y = *(TYPE *)(b + i);        \
+        *(TYPE *)(d + i) = EXPR;                                \
+    }
+
+/* The element loops of the helpers in accel/tcg/tcg-runtime-gvec.c. */
+static void do_loop(GVecAccelOp op, void *d, void *a, void *b,
+                    intptr_t i, intptr_t oprsz)
+{
+    switch (op) {
+    case GVEC_ACCEL_ADD8:
+        DO_LOOP(uint8_t, x + y);
+        break;
+    case GVEC_ACCEL_ADD16:
+        DO_LOOP(uint16_t, x + y);
+        break;
+    case GVEC_ACCEL_ADD32:
+        DO_LOOP(uint32_t, x + y);
+        break;
+    case GVEC_ACCEL_ADD64:
+        DO_LOOP(uint64_t, x + y);
+        break;
+    case GVEC_ACCEL_SUB8:
+        DO_LOOP(uint8_t, x - y);
+        break;
+    case GVEC_ACCEL_SUB16:
+        DO_LOOP(uint16_t, x - y);
+        break;
+    case GVEC_ACCEL_SUB32:
+        DO_LOOP(uint32_t, x - y);
+        break;
+    case GVEC_ACCEL_SUB64:
+        DO_LOOP(uint64_t, x - y);
+        break;
+    case GVEC_ACCEL_AND:
+        DO_LOOP(uint64_t, x & y);
+        break;
+    case GVEC_ACCEL_OR:
+        DO_LOOP(uint64_t, x | y);
+        break;
+    case GVEC_ACCEL_XOR:
+        DO_LOOP(uint64_t, x ^ y);
+        break;
+    case GVEC_ACCEL_ANDC:
+        DO_LOOP(uint64_t, x & ~y);
+        break;
+    default:
+        g_assert_not_reached();
+    }
+}
+
+static void do_op(GVecAccelOp op, void *d, void *a, void *b, intptr_t oprsz)
+{
+    do_loop(op, d, a, b, gvec_accel(op, d, a, b, oprsz), oprsz);
+}
+
+static void test(const void *opaque)
+{
+    intptr_t max = sizes[ARRAY_SIZE(sizes) - 1];
+    uint8_t *a = g_malloc(max), *b = g_malloc(max);
+    uint8_t *d = g_malloc(max), *ref = g_malloc(max);
+
+    for (intptr_t i = 0; i < max; i++) {
+        a[i] = g_test_rand_int();
+        b[i] = g_test_rand_int();
+    }
+
+    do {
+        for (GVecAccelOp op = 0; op < GVEC_ACCEL_NB_OPS; op++) {
+            do_loop(op, ref, a, b, 0, max);
+
+            for (size_t j = 0; j < ARRAY_SIZE(sizes); j++) {
+                intptr_t len = sizes[j];
+                double total = 0.0;
+
+                g_test_timer_start();
+                do {
+                    for (int k = 0; k < 1000; k++) {
+                        do_op(op, d, a, b, len);
+                    }
+                    total += len * 1000;
+                } while (g_test_timer_elapsed() < 0.1);
+
+                g_assert(memcmp(d, ref, len) == 0);
+                total /= MiB;
+                g_test_message("gvec %-6s %-5s: %3" PRIdPTR " bytes"
+                               " %8.0f MB/sec", gvec_accel_name(),
+                               op_names[op], len, total / g_test_timer_last());
+            }
+        }
+    } while (test_gvec_accel_next());
+
+    g_free(a);
+    g_free(b);
+    g_free(d);
+    g_free(ref);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_data_func("/tcg/gvec/speed", NULL, test);
+    return g_test_run();
+}
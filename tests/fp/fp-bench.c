@@ -34,6 +34,8 @@ enum op {
     OP_FMA,
     OP_SQRT,
     OP_CMP,
+    OP_TO_INT,
+    OP_FROM_INT,
     OP_MAX_NR,
 };
 
@@ -45,6 +47,8 @@ static const char * const op_names[] = {
     [OP_FMA] = "mulAdd",
     [OP_SQRT] = "sqrt",
     [OP_CMP] = "cmp",
+    [OP_TO_INT] = "to_int",
+    [OP_FROM_INT] = "from_int",
     [OP_MAX_NR] = NULL,
 };
 
@@ -225,6 +229,33 @@ static void fill_random(union fp *ops, int n_ops, enum precision prec,
     }
 }
 
+/*
+ * Random exponents would make nearly every float to int conversion
+ * overflow, so give the operand a magnitude in [1, 2^31) instead.
+ */
+static void fit_int_range(union fp *op, enum precision prec)
+{
+    switch (prec) {
+    case PREC_SINGLE:
+    case PREC_FLOAT32:
+        op->f32 = (op->f32 & 0x807fffff) |
+                  ((0x7f + ((op->f32 >> 23) & 31)) << 23);
+        break;
+    case PREC_DOUBLE:
+    case PREC_FLOAT64:
+        op->f64 = (op->f64 & 0x800fffffffffffffULL) |
+                  ((0x3ffULL + ((op->f64 >> 52) & 31)) << 52);
+        break;
+    case PREC_QUAD:
+    case PREC_FLOAT128:
+        op->f128.high = (op->f128.high & 0x8000ffffffffffffULL) |
+                        ((0x3fffULL + ((op->f128.high >> 48) & 31)) << 48);
+        break;
+    default:
+        g_assert_not_reached();
+    }
+}
+
 /*
  * The main benchmark function. Instead of (ab)using macros, we rely
  * on the compiler to unfold this at compile-time.
@@ -242,6 +273,9 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
         switch (prec) {
         case PREC_SINGLE:
             fill_random(ops, n_ops, prec, no_neg);
+            if (op == OP_TO_INT) {
+                fit_int_range(&ops[0], prec);
+            }
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float a = ops[0].f;
@@ -270,6 +304,12 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = isgreater(a, b);
                     break;
+                case OP_TO_INT:
+                    res.u64 = llrintf(a);
+                    break;
+                case OP_FROM_INT:
+                    res.f = (int32_t)ops[0].u64;
+                    break;
                 default:
                     g_assert_not_reached();
                 }
@@ -277,6 +317,9 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
             break;
         case PREC_DOUBLE:
             fill_random(ops, n_ops, prec, no_neg);
+            if (op == OP_TO_INT) {
+                fit_int_range(&ops[0], prec);
+            }
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 double a = ops[0].d;
@@ -305,6 +348,12 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = isgreater(a, b);
                     break;
+                case OP_TO_INT:
+                    res.u64 = llrint(a);
+                    break;
+                case OP_FROM_INT:
+                    res.d = (int32_t)ops[0].u64;
+                    break;
                 default:
                     g_assert_not_reached();
                 }
@@ -312,6 +361,9 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
             break;
         case PREC_FLOAT32:
             fill_random(ops, n_ops, prec, no_neg);
+            if (op == OP_TO_INT) {
+                fit_int_range(&ops[0], prec);
+            }
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float32 a = ops[0].f32;
@@ -340,6 +392,13 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = float32_compare_quiet(a, b, &soft_status);
                     break;
+                case OP_TO_INT:
+                    res.u64 = float32_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f32 = int32_to_float32((int32_t)ops[0].u64,
+                                               &soft_status);
+                    break;
                 default:
                     g_assert_not_reached();
                 }
@@ -347,6 +406,9 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
             break;
         case PREC_FLOAT64:
             fill_random(ops, n_ops, prec, no_neg);
+            if (op == OP_TO_INT) {
+                fit_int_range(&ops[0], prec);
+            }
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float64 a = ops[0].f64;
@@ -375,6 +437,13 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = float64_compare_quiet(a, b, &soft_status);
                     break;
+                case OP_TO_INT:
+                    res.u64 = float64_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f64 = int32_to_float64((int32_t)ops[0].u64,
+                                               &soft_status);
+                    break;
                 default:
                     g_assert_not_reached();
                 }
@@ -382,6 +451,9 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
             break;
         case PREC_FLOAT128:
             fill_random(ops, n_ops, prec, no_neg);
+            if (op == OP_TO_INT) {
+                fit_int_range(&ops[0], prec);
+            }
             t0 = get_clock();
             for (i = 0; i < OPS_PER_ITER; i++) {
                 float128 a = ops[0].f128;
@@ -410,6 +482,13 @@ static void bench(enum precision prec, enum op op, int n_ops, bool no_neg)
                 case OP_CMP:
                     res.u64 = float128_compare_quiet(a, b, &soft_status);
                     break;
+                case OP_TO_INT:
+                    res.u64 = float128_to_int64(a, &soft_status);
+                    break;
+                case OP_FROM_INT:
+                    res.f128 = int32_to_float128((int32_t)ops[0].u64,
+                                                 &soft_status);
+                    break;
                 default:
                     g_assert_not_reached();
                 }
@@ -448,6 +527,8 @@ GEN_BENCH_ALL_TYPES(mul, OP_MUL, 2)
 GEN_BENCH_ALL_TYPES(div, OP_DIV, 2)
 GEN_BENCH_ALL_TYPES(fma, OP_FMA, 3)
 GEN_BENCH_ALL_TYPES(cmp, OP_CMP, 2)
+GEN_BENCH_ALL_TYPES(to_int, OP_TO_INT, 1)
+GEN_BENCH_ALL_TYPES(from_int, OP_FROM_INT, 1)
 #undef GEN_BENCH_ALL_TYPES
 
 #define GEN_BENCH_ALL_TYPES_NO_NEG(name, op, n)                         \
@@ -480,6 +561,8 @@ static const bench_func_t bench_funcs[OP_MAX_NR][PREC_MAX_NR] = {
     GEN_BENCH_FUNCS(fma, OP_FMA),
     GEN_BENCH_FUNCS(sqrt, OP_SQRT),
     GEN_BENCH_FUNCS(cmp, OP_CMP),
+    GEN_BENCH_FUNCS(to_int, OP_TO_INT),
+    GEN_BENCH_FUNCS(from_int, OP_FROM_INT),
 };
 
 #undef GEN_BENCH_FUNCS
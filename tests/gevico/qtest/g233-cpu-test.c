@@ -15,7 +15,11 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/units.h"
 #include "libqtest.h"
+#include "elf.h"
+#include "qobject/qdict.h"
+#include "qobject/qlist.h"
 
 static void run_test_csr(void)
 {
@@ -24,11 +28,214 @@ static void run_test_csr(void)
     qtest_quit(qts);
 }
 
+static QList *get_cpus(QTestState *qts, QDict **resp)
+{
+    *resp = qtest_qmp(qts, "{ 'execute': 'query-cpus-fast' }");
+    g_assert(*resp);
+    g_assert(qdict_haskey(*resp, "return"));
+    return qdict_get_qlist(*resp, "return");
+}
+
+static void run_test_smp(void)
+{
+    QTestState *qts = qtest_init("-machine g233 -smp 8");
+    unsigned long seen = 0;
+    QDict *resp;
+    QList *cpus;
+    QObject *e;
+
+    cpus = get_cpus(qts, &resp);
+    g_assert_cmpint(qlist_size(cpus), ==, 8);
+    while ((e = qlist_pop(cpus))) {
+        QDict *cpu = qobject_to(QDict, e);
+        int64_t cpu_idx = qdict_get_int(cpu, "cpu-index");
+
+        g_assert_cmpint(cpu_idx, >=, 0);
+        g_assert_cmpint(cpu_idx, <, 8);
+        g_assert_false(seen & BIT(cpu_idx));
+        seen |= BIT(cpu_idx);
+        qobject_unref(e);
+    }
+    g_assert_cmphex(seen, ==, 0xff);
+
+    qobject_unref(resp);
+    qtest_quit(qts);
+}
+
+static void run_test_numa(void)
+{
+    QTestState *qts = qtest_init("-machine g233 -m 2G -smp 4,sockets=2 "
+                                 "-numa node,mem=1G,cpus=0-1 "
+                                 "-numa node,mem=1G,cpus=2-3");
+    g_autofree char *info = NULL;
+    QDict *resp, *mem;
+    QList *cpus;
+    QObject *e;
+
+    cpus = get_cpus(qts, &resp);
+    g_assert_cmpint(qlist_size(cpus), ==, 4);
+    while ((e = qlist_pop(cpus))) {
+        QDict *cpu = qobject_to(QDict, e);
+        QDict *props = qdict_get_qdict(cpu, "props");
+        int64_t cpu_idx = qdict_get_int(cpu, "cpu-index");
+
+        g_assert(qdict_haskey(props, "node-id"));
+        g_assert_cmpint(qdict_get_int(props, "node-id"), ==, cpu_idx / 2);
+        qobject_unref(e);
+    }
+    qobject_unref(resp);
+
+    resp = qtest_qmp(qts, "{ 'execute': 'query-memory-size-summary' }");
+    g_assert(qdict_haskey(resp, "return"));
+    mem = qdict_get_qdict(resp, "return");
+    g_assert_cmpuint(qdict_get_int(mem, "base-memory"), ==, 2 * GiB);
+    qobject_unref(resp);
+
+    info = qtest_hmp(qts, "info numa");
+    g_assert(strstr(info, "node 0 cpus: 0 1"));
+    g_assert(strstr(info, "node 0 size: 1024 MB"));
+    g_assert(strstr(info, "node 1 cpus: 2 3"));
+    g_assert(strstr(info, "node 1 size: 1024 MB"));
+
+    qtest_quit(qts);
+}
+
+#define G233_MROM_START_ADDR     0x1018
+#define G233_MROM_FDT_ADDR       0x1020
+#define G233_DRAM_BASE           0x80000000ULL
+#define FDT_MAGIC                0xd00dfeed
+
+static void run_test_fdt(void)
+{
+    QTestState *qts = qtest_init("-machine g233");
+    uint64_t fdt_addr = qtest_readq(qts, G233_MROM_FDT_ADDR);
+
+    /* The trampoline hands the generated DTB to the payload in a1 */
+    g_assert_cmphex(qtest_readq(qts, G233_MROM_START_ADDR), ==,
+                    G233_DRAM_BASE);
+    g_assert_cmpuint(fdt_addr, >=, G233_DRAM_BASE);
+    g_assert_cmphex(be32_to_cpu(qtest_readl(qts, fdt_addr)), ==, FDT_MAGIC);
+
+    qtest_quit(qts);
+}
+
+static void run_test_direct_boot(void)
+{
+    static const uint32_t image[] = { 0x0000006f };   /* j . */
+    g_autofree char *path = NULL;
+    GError *err = NULL;
+    QTestState *qts;
+    int fd;
+
+    fd = g_file_open_tmp("g233-kernel-XXXXXX", &path, &err);
+    g_assert_no_error(err);
+    g_assert_cmpint(write(fd, image, sizeof(image)), ==, sizeof(image));
+    close(fd);
+
+    qts = qtest_initf("-machine g233,direct-boot=on -kernel %s", path);
+    g_assert_cmphex(qtest_readl(qts, G233_DRAM_BASE), ==, image[0]);
+    g_assert_cmphex(be32_to_cpu(qtest_readl(qts,
+                    qtest_readq(qts, G233_MROM_FDT_ADDR))), ==, FDT_MAGIC);
+    qtest_quit(qts);
+
+    unlink(path);
+}
+
+#define G233_ELF_LOAD_ADDR       (G233_DRAM_BASE + 2 * MiB)
+
+/* Minimal ELF64 executable: one PT_LOAD segment holding "j ." */
+typedef struct QEMU_PACKED {
+    Elf64_Ehdr ehdr;
+    Elf64_Phdr phdr;
+    uint32_t insn;
+} G233TestElf;
+
+static char *write_test_elf(void)
+{
+    G233TestElf elf = {
+        .ehdr = {
+            .e_ident = { ELFMAG0, ELFMAG1, ELFMAG2, ELFMAG3,
+                         ELFCLASS64, ELFDATA2LSB, EV_CURRENT },
+            .e_type = cpu_to_le16(ET_EXEC),
+            .e_machine = cpu_to_le16(EM_RISCV),
+            .e_version = cpu_to_le32(EV_CURRENT),
+            .e_entry = cpu_to_le64(G233_ELF_LOAD_ADDR),
+            .e_phoff = cpu_to_le64(offsetof(G233TestElf, phdr)),
+            .e_ehsize = cpu_to_le16(sizeof(Elf64_Ehdr)),
+            .e_phentsize = cpu_to_le16(sizeof(Elf64_Phdr)),
+            .e_phnum = cpu_to_le16(1),
+        },
+        .phdr = {
+            .p_type = cpu_to_le32(PT_LOAD),
+            .p_flags = cpu_to_le32(PF_R | PF_X),
+            .p_offset = cpu_to_le64(offsetof(G233TestElf, insn)),
+            .p_vaddr = cpu_to_le64(G233_ELF_LOAD_ADDR),
+            .p_paddr = cpu_to_le64(G233_ELF_LOAD_ADDR),
+            .p_filesz = cpu_to_le64(sizeof(uint32_t)),
+            .p_memsz = cpu_to_le64(sizeof(uint32_t)),
+            .p_align = cpu_to_le64(sizeof(uint32_t)),
+        },
+        .insn = cpu_to_le32(0x0000006f),    /* j . */
+    };
+    char *path = NULL;
+    GError *err = NULL;
+    int fd;
+
+    fd = g_file_open_tmp("g233-kernel-XXXXXX.elf", &path, &err);
+    g_assert_no_error(err);
+    g_assert_cmpint(write(fd, &elf, sizeof(elf)), ==, sizeof(elf));
+    close(fd);
+
+    return path;
+}
+
+/* Pull one register value out of an "info registers" dump */
+static uint64_t get_reg(const char *dump, const char *name)
+{
+    g_autofree char *key = g_strdup_printf(" %s ", name);
+    const char *p = strstr(dump, key);
+
+    g_assert_nonnull(p);
+    return g_ascii_strtoull(p + strlen(key), NULL, 16);
+}
+
+static void run_test_direct_boot_elf(void)
+{
+    g_autofree char *path = write_test_elf();
+    QTestState *qts;
+    uint64_t fdt_addr;
+    int hart;
+
+    qts = qtest_initf("-machine g233,direct-boot=on -smp 2 -kernel %s",
+                      path);
+    fdt_addr = qtest_readq(qts, G233_MROM_FDT_ADDR);
+
+    /* The segment is written straight into DRAM, not via a ROM blob */
+    g_assert_cmphex(qtest_readl(qts, G233_ELF_LOAD_ADDR), ==, 0x0000006f);
+    g_assert_cmphex(be32_to_cpu(qtest_readl(qts, fdt_addr)), ==, FDT_MAGIC);
+
+    for (hart = 0; hart < 2; hart++) {
+        g_autofree char *dump = qtest_hmp(qts, "info registers %d", hart);
+
+        g_assert_cmphex(get_reg(dump, "pc"), ==, G233_ELF_LOAD_ADDR);
+        g_assert_cmphex(get_reg(dump, "x10/a0"), ==, hart);
+        g_assert_cmphex(get_reg(dump, "x11/a1"), ==, fdt_addr);
+    }
+
+    qtest_quit(qts);
+    unlink(path);
+}
+
 int main(int argc, char **argv)
 {
     g_test_init(&argc, &argv, NULL);
 
     qtest_add_func("g233/cpu/csr", run_test_csr);
+    qtest_add_func("g233/cpu/smp", run_test_smp);
+    qtest_add_func("g233/cpu/numa", run_test_numa);
+    qtest_add_func("g233/boot/fdt", run_test_fdt);
+    qtest_add_func("g233/boot/direct", run_test_direct_boot);
+    qtest_add_func("g233/boot/direct-elf", run_test_direct_boot_elf);
 
     return g_test_run();
 }
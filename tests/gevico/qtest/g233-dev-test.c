@@ -16,6 +16,52 @@
 
 #include "qemu/osdep.h"
 #include "libqtest.h"
+#include "qobject/qdict.h"
+
+#define G233_SPI_BASE       0x10018000
+#define SPI_CR1             0x00
+#define SPI_CR1_MSTR        (1 << 2)
+#define SPI_CR1_SPE         (1 << 6)
+#define SPI_SR              0x08
+#define SPI_SR_RXNE         (1 << 0)
+#define SPI_DR              0x0C
+#define SPI_CSCTRL          0x10
+#define SPI_CS0_ON          ((1 << 0) | (1 << 4))
+#define SPI_CS0_OFF         (1 << 0)
+
+#define FLASH_SIZE          (2 * 1024 * 1024)   /* w25x16 */
+#define FLASH_READ_DATA     0x03
+#define FLASH_READ_ADDR     0x100
+#define FLASH_READ_LEN      8
+
+static uint8_t flash_pattern(uint32_t addr)
+{
+    return (addr * 7) ^ 0x5a;
+}
+
+static uint8_t spi_transfer(QTestState *qts, uint8_t data)
+{
+    qtest_writel(qts, G233_SPI_BASE + SPI_DR, data);
+    g_assert(qtest_readl(qts, G233_SPI_BASE + SPI_SR) & SPI_SR_RXNE);
+    return qtest_readl(qts, G233_SPI_BASE + SPI_DR);
+}
+
+static void wait_migration_complete(QTestState *qts)
+{
+    for (;;) {
+        QDict *rsp = qtest_qmp_assert_success_ref(qts,
+                                                  "{'execute': 'query-migrate'}");
+        const char *status = qdict_get_try_str(rsp, "status");
+        bool done = status && !strcmp(status, "completed");
+
+        g_assert(!status || strcmp(status, "failed"));
+        qobject_unref(rsp);
+        if (done) {
+            return;
+        }
+        g_usleep(1000);
+    }
+}
 
 static void run_test_csr(void)
 {
@@ -24,11 +70,82 @@ static void run_test_csr(void)
     qtest_quit(qts);
 }
 
+/*
+ * Save the board in the middle of a flash read, with a received byte
+ * still sitting in the RX FIFO and CS0 asserted, then restore it in a
+ * fresh instance and check the transfer carries on where it left off.
+ */
+static void run_test_spi_snapshot(void)
+{
+    g_autofree uint8_t *image = g_malloc(FLASH_SIZE);
+    g_autofree char *flash = NULL;
+    g_autofree char *state = NULL;
+    g_autofree char *uri = NULL;
+    GError *err = NULL;
+    QTestState *qts;
+    uint32_t sr, csctrl;
+    int fd, i;
+
+    for (i = 0; i < FLASH_SIZE; i++) {
+        image[i] = flash_pattern(i);
+    }
+    fd = g_file_open_tmp("g233-flash-XXXXXX", &flash, &err);
+    g_assert_no_error(err);
+    close(fd);
+    g_file_set_contents(flash, (char *)image, FLASH_SIZE, &err);
+    g_assert_no_error(err);
+    fd = g_file_open_tmp("g233-state-XXXXXX", &state, &err);
+    g_assert_no_error(err);
+    close(fd);
+    uri = g_strdup_printf("file:%s", state);
+
+    qts = qtest_initf("-machine g233 -drive if=none,id=flash0,format=raw,"
+                      "file=%s", flash);
+    qtest_writel(qts, G233_SPI_BASE + SPI_CR1, SPI_CR1_MSTR | SPI_CR1_SPE);
+    qtest_writel(qts, G233_SPI_BASE + SPI_CSCTRL, SPI_CS0_ON);
+    spi_transfer(qts, FLASH_READ_DATA);
+    spi_transfer(qts, (FLASH_READ_ADDR >> 16) & 0xff);
+    spi_transfer(qts, (FLASH_READ_ADDR >> 8) & 0xff);
+    spi_transfer(qts, FLASH_READ_ADDR & 0xff);
+    for (i = 0; i < FLASH_READ_LEN / 2; i++) {
+        g_assert_cmphex(spi_transfer(qts, 0), ==,
+                        flash_pattern(FLASH_READ_ADDR + i));
+    }
+    /* Leave the next byte in the RX FIFO */
+    qtest_writel(qts, G233_SPI_BASE + SPI_DR, 0);
+    sr = qtest_readl(qts, G233_SPI_BASE + SPI_SR);
+    csctrl = qtest_readl(qts, G233_SPI_BASE + SPI_CSCTRL);
+    g_assert(sr & SPI_SR_RXNE);
+
+    qtest_qmp_assert_success(qts, "{'execute': 'migrate',"
+                             " 'arguments': {'uri': %s}}", uri);
+    wait_migration_complete(qts);
+    qtest_quit(qts);
+
+    qts = qtest_initf("-machine g233 -drive if=none,id=flash0,format=raw,"
+                      "file=%s -incoming %s", flash, uri);
+    qtest_qmp_eventwait(qts, "RESUME");
+    g_assert_cmphex(qtest_readl(qts, G233_SPI_BASE + SPI_SR), ==, sr);
+    g_assert_cmphex(qtest_readl(qts, G233_SPI_BASE + SPI_CSCTRL), ==, csctrl);
+    g_assert_cmphex(qtest_readl(qts, G233_SPI_BASE + SPI_DR), ==,
+                    flash_pattern(FLASH_READ_ADDR + FLASH_READ_LEN / 2));
+    for (i = FLASH_READ_LEN / 2 + 1; i < FLASH_READ_LEN; i++) {
+        g_assert_cmphex(spi_transfer(qts, 0), ==,
+                        flash_pattern(FLASH_READ_ADDR + i));
+    }
+    qtest_writel(qts, G233_SPI_BASE + SPI_CSCTRL, SPI_CS0_OFF);
+    qtest_quit(qts);
+
+    unlink(state);
+    unlink(flash);
+}
+
 int main(int argc, char **argv)
 {
     g_test_init(&argc, &argv, NULL);
 
     qtest_add_func("g233/dev/csr", run_test_csr);
+    qtest_add_func("g233/dev/spi-snapshot", run_test_spi_snapshot);
 
     return g_test_run();
 }
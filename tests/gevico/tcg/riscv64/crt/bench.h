@@ -0,0 +1,40 @@
+/*
+ * Gevico TCG system benchmark helpers
+ *
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ */
+
+#ifndef GEVICO_BENCH_H
+#define GEVICO_BENCH_H
+
+#include "crt.h"
+
+/* ACLINT mtime of the G233 board, counting from machine start */
+#define BENCH_MTIME_ADDR    0x0200bff8UL
+#define BENCH_MTIME_FREQ    32768
+
+static inline uint64_t bench_mtime(void)
+{
+    return *(volatile uint64_t *)BENCH_MTIME_ADDR;
+}
+
+static inline uint64_t bench_mtime_to_us(uint64_t ticks)
+{
+    return ticks * 1000000 / BENCH_MTIME_FREQ;
+}
+
+/* Events (bytes, toggles, ...) per second over an mtime interval */
+static inline uint64_t bench_rate(uint64_t count, uint64_t ticks)
+{
+    return ticks ? count * BENCH_MTIME_FREQ / ticks : 0;
+}
+
+/*
+ * Every result is printed on a line of its own as
+ *   BENCH <name> <value> <unit>
+ * so that it can be collected with grep by `make bench`.
+ */
+#define bench_report(name, value, unit) \
+    printf("BENCH %s %ld %s\n", name, (long)(value), unit)
+
+#endif /* GEVICO_BENCH_H */
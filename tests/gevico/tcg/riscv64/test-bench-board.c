@@ -0,0 +1,203 @@
+/*
+ * Boot and peripheral access benchmarks for the G233 board
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "crt.h"
+#include "pl011.h"
+#include "bench.h"
+
+#define G233_GPIO_BASE      0x10012000
+#define GPIO_OUTPUT_EN      0x08
+#define GPIO_PORT           0x0C
+
+#define G233_SPI_BASE       0x10018000
+#define SPI_CR1             0x00
+#define SPI_CR1_MSTR        (1 << 2)
+#define SPI_CR1_SPE         (1 << 6)
+#define SPI_SR              0x08
+#define SPI_SR_RXNE         (1 << 0)
+#define SPI_SR_TXE          (1 << 1)
+#define SPI_SR_DMADONE      (1 << 8)
+#define SPI_DR              0x0C
+#define SPI_CSCTRL          0x10
+#define SPI_CS0_ON          ((1 << 0) | (1 << 4))
+#define SPI_CS0_OFF         (1 << 0)
+#define SPI_DMAADDR         0x14
+#define SPI_DMALEN          0x18
+#define SPI_DMACR           0x1C
+#define SPI_DMACR_START     (1 << 0)
+
+#define FLASH_READ_DATA     0x03
+
+#define GPIO_TOGGLES        (100 * 1000)
+#define SPI_CS_TOGGLES      (100 * 1000)
+#define SPI_PIO_LEN         (64 * 1024)
+#define SPI_DMA_LEN         (1024 * 1024)
+#define UART_LINES          16
+#define UART_LINE_LEN       128
+#define INSN_BUF_LEN        (64 * 1024)
+#define INSN_ROUNDS         64
+
+#define REG32(base, off) (*(volatile uint32_t *)((uintptr_t)(base) + (off)))
+
+static uint8_t buf[SPI_DMA_LEN];
+static uint8_t out[2 * INSN_BUF_LEN];
+
+static void bench_boot(uint64_t main_entry)
+{
+    bench_report("boot_to_main", bench_mtime_to_us(main_entry), "us");
+}
+
+static void bench_gpio(void)
+{
+    uint64_t start, end;
+
+    REG32(G233_GPIO_BASE, GPIO_OUTPUT_EN) = 1;
+    start = bench_mtime();
+    for (int i = 0; i < GPIO_TOGGLES; i++) {
+        REG32(G233_GPIO_BASE, GPIO_PORT) = i & 1;
+    }
+    end = bench_mtime();
+    REG32(G233_GPIO_BASE, GPIO_OUTPUT_EN) = 0;
+
+    bench_report("gpio_toggle", bench_rate(GPIO_TOGGLES, end - start),
+                 "toggles/s");
+}
+
+static uint8_t spi_transfer(uint8_t data)
+{
+    while (!(REG32(G233_SPI_BASE, SPI_SR) & SPI_SR_TXE)) {
+    }
+    REG32(G233_SPI_BASE, SPI_DR) = data;
+    while (!(REG32(G233_SPI_BASE, SPI_SR) & SPI_SR_RXNE)) {
+    }
+    return REG32(G233_SPI_BASE, SPI_DR);
+}
+
+static void spi_start_read(void)
+{
+    REG32(G233_SPI_BASE, SPI_CSCTRL) = SPI_CS0_ON;
+    spi_transfer(FLASH_READ_DATA);
+    spi_transfer(0);
+    spi_transfer(0);
+    spi_transfer(0);
+}
+
+static void bench_spi(void)
+{
+    uint64_t start, end;
+
+    REG32(G233_SPI_BASE, SPI_CR1) = SPI_CR1_MSTR | SPI_CR1_SPE;
+
+    /* Bit-banged chip select, as done by firmware driving raw SPI */
+    start = bench_mtime();
+    for (int i = 0; i < SPI_CS_TOGGLES; i++) {
+        REG32(G233_SPI_BASE, SPI_CSCTRL) = (i & 1) ? SPI_CS0_ON : SPI_CS0_OFF;
+    }
+    REG32(G233_SPI_BASE, SPI_CSCTRL) = SPI_CS0_OFF;
+    end = bench_mtime();
+    bench_report("spi_cs_toggle", bench_rate(SPI_CS_TOGGLES, end - start),
+                 "toggles/s");
+
+    start = bench_mtime();
+    spi_start_read();
+    for (int i = 0; i < SPI_PIO_LEN; i++) {
+        buf[i] = spi_transfer(0);
+    }
+    REG32(G233_SPI_BASE, SPI_CSCTRL) = SPI_CS0_OFF;
+    end = bench_mtime();
+    bench_report("spi_flash_read_pio", bench_rate(SPI_PIO_LEN, end - start),
+                 "B/s");
+
+    start = bench_mtime();
+    spi_start_read();
+    REG32(G233_SPI_BASE, SPI_DMAADDR) = (uint32_t)(uintptr_t)buf;
+    REG32(G233_SPI_BASE, SPI_DMALEN) = SPI_DMA_LEN;
+    REG32(G233_SPI_BASE, SPI_DMACR) = SPI_DMACR_START;
+    while (!(REG32(G233_SPI_BASE, SPI_SR) & SPI_SR_DMADONE)) {
+    }
+    REG32(G233_SPI_BASE, SPI_SR) = SPI_SR_DMADONE;
+    REG32(G233_SPI_BASE, SPI_CSCTRL) = SPI_CS0_OFF;
+    end = bench_mtime();
+    bench_report("spi_flash_read_dma", bench_rate(SPI_DMA_LEN, end - start),
+                 "B/s");
+}
+
+static void uart_putc(int ch)
+{
+    while (REG32(PL011_IO_BASE, UART_FR) & UART_FR_TXFF) {
+    }
+    REG32(PL011_IO_BASE, UART_DR) = ch;
+}
+
+static void bench_uart(void)
+{
+    uint64_t start, end;
+
+    start = bench_mtime();
+    for (int i = 0; i < UART_LINES; i++) {
+        for (int j = 0; j < UART_LINE_LEN - 1; j++) {
+            uart_putc('.');
+        }
+        uart_putc('\n');
+    }
+    end = bench_mtime();
+
+    bench_report("uart_tx", bench_rate(UART_LINES * UART_LINE_LEN,
+                                       end - start), "B/s");
+}
+
+static void bench_insn(void)
+{
+    uintptr_t src = (uintptr_t)buf;
+    uintptr_t dst = (uintptr_t)out;
+    int num = INSN_BUF_LEN;
+    uint64_t start, end;
+
+    start = bench_mtime();
+    for (int i = 0; i < INSN_ROUNDS; i++) {
+        asm volatile (".insn r 0x7b, 6, 38, %0, %1, %2"
+                      : : "r"(dst), "r"(src), "r"(num) : "memory");
+    }
+    end = bench_mtime();
+    bench_report("insn_crush", bench_rate(INSN_ROUNDS * INSN_BUF_LEN,
+                                          end - start), "B/s");
+
+    start = bench_mtime();
+    for (int i = 0; i < INSN_ROUNDS; i++) {
+        asm volatile (".insn r 0x7b, 6, 54, %0, %1, %2"
+                      : : "r"(dst), "r"(src), "r"(num) : "memory");
+    }
+    end = bench_mtime();
+    bench_report("insn_expand", bench_rate(INSN_ROUNDS * INSN_BUF_LEN,
+                                           end - start), "B/s");
+
+    num = INSN_BUF_LEN / 4;
+    start = bench_mtime();
+    for (int i = 0; i < INSN_ROUNDS; i++) {
+        /* Sorting a sorted array is the no-store best case, so reshuffle */
+        for (int j = 0; j < num; j++) {
+            ((uint32_t *)buf)[j] = j * 2654435761u;
+        }
+        asm volatile (".insn r 0x7b, 6, 22, %0, %1, %2"
+                      : : "r"(num), "r"(src), "r"(num) : "memory");
+    }
+    end = bench_mtime();
+    bench_report("insn_sort", bench_rate(INSN_ROUNDS * num, end - start),
+                 "words/s");
+}
+
+int main(void)
+{
+    uint64_t main_entry = bench_mtime();
+
+    printf("G233 board benchmarks\n");
+    bench_boot(main_entry);
+    bench_gpio();
+    bench_spi();
+    bench_uart();
+    bench_insn();
+    return 0;
+}
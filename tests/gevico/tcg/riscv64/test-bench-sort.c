@@ -0,0 +1,50 @@
+#include "crt.h"
+#include "bench.h"
+
+#define BENCH_MAX_NUM   (1024 * 1024)
+
+static uint32_t bench_buf[BENCH_MAX_NUM];
+
+static void custom_sort(uintptr_t addr, int array_num, int sort_num)
+{
+    asm volatile (
+       ".insn r 0x7b, 6, 22, %0, %1, %2"
+        : :"r"(sort_num), "r"(addr), "r"(array_num) : "memory");
+}
+
+static void fill_random(uint32_t arr[], int n, uint32_t seed)
+{
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        arr[i] = seed;
+    }
+}
+
+static void check_sorted(uint32_t arr[], int n)
+{
+    for (int i = 0; i + 1 < n; i++) {
+        crt_assert(arr[i] <= arr[i + 1]);
+    }
+}
+
+static void bench_sort(int n)
+{
+    uint64_t start, end;
+
+    fill_random(bench_buf, n, n);
+    start = bench_mtime();
+    custom_sort((uintptr_t)bench_buf, n, n);
+    end = bench_mtime();
+    check_sorted(bench_buf, n);
+
+    printf("BENCH sort_%d %ld us\n", n, (long)bench_mtime_to_us(end - start));
+}
+
+int main(void)
+{
+    printf("Hello, RISC-V G233 Board\n");
+    bench_sort(1024);
+    bench_sort(64 * 1024);
+    bench_sort(BENCH_MAX_NUM);
+    return 0;
+}
@@ -40,9 +40,26 @@ void print_array(uint8_t arr[], int n) {
     }
     printf("\n");
 }
+/* A constant count loaded right before the insn takes the inline path */
+static void test_crush_inline(void)
+{
+    uint8_t src[7] = {0x1A, 0x2B, 0x3C, 0x4D, 0x5E, 0x6F, 0x70};
+    uint8_t dst1[4];
+    uint8_t dst2[4] = {0xff, 0xff, 0xff, 0xff};
+    size_t dst_len;
+
+    pack_low4bits(src, 7, dst1, &dst_len);
+    asm volatile (
+       "li t0, 7\n"
+       ".insn r 0x7b, 6, 38, %0, %1, t0"
+        : :"r"((uintptr_t)dst2), "r"((uintptr_t)src) : "t0", "memory");
+    compare(dst1, dst2, dst_len);
+}
+
 int main(void)
 {
     printf("Hello, RISC-V G233 Board\n");
+    test_crush_inline();
     uint8_t src[] = {0xA, 0xB, 0xC, 0xD, 0xE, 0xF, 0x1, 0x2, 0x3, 0x4};
     size_t src_len = sizeof(src) / sizeof(src[0]);
     uint8_t dst1[(src_len + 1) / 2];
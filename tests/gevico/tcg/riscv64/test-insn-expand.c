@@ -32,9 +32,26 @@ void print_array(uint8_t arr[], int n) {
     printf("\n");
 }
 
+/* A constant count loaded right before the insn takes the inline path */
+static void test_expand_inline(void)
+{
+    uint8_t src[5] = {0x1A, 0x2B, 0x3C, 0x4D, 0x5E};
+    uint8_t dst1[10];
+    uint8_t dst2[10];
+    size_t dst_len;
+
+    split_to_4bits(src, 5, dst1, &dst_len);
+    asm volatile (
+       "li t0, 5\n"
+       ".insn r 0x7b, 6, 54, %0, %1, t0"
+        : :"r"((uintptr_t)dst2), "r"((uintptr_t)src) : "t0", "memory");
+    compare(dst1, dst2, dst_len);
+}
+
 int main(void)
 {
     printf("Hello, RISC-V G233 Board\n");
+    test_expand_inline();
     uint8_t src[] = {0xAB, 0xBC, 0xCD, 0xDE, 0xEF, 0xFA, 0x13, 0x24, 0x63, 0x74};
     size_t src_len = sizeof(src) / sizeof(src[0]);
     uint8_t dst1[src_len * 2];
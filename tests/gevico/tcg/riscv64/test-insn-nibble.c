@@ -0,0 +1,161 @@
+#include "crt.h"
+
+#define PAGE_SIZE       4096
+#define GUARD           0xAA
+/* Unassigned address right after the mask ROM */
+#define HOLE_ADDR       0x3000
+#define CAUSE_LOAD_ACCESS_FAULT 5
+
+static uint8_t src[8 * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static uint8_t dst1[8 * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static uint8_t dst2[8 * PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+volatile uint64_t fault_cause;
+volatile uint64_t fault_addr;
+void fault_trap(void);
+
+asm(".balign 4\n"
+    "fault_trap:\n"
+    "    addi    sp, sp, -16\n"
+    "    sd      t0, 0(sp)\n"
+    "    sd      t1, 8(sp)\n"
+    "    csrr    t0, mcause\n"
+    "    lla     t1, fault_cause\n"
+    "    sd      t0, 0(t1)\n"
+    "    csrr    t0, mtval\n"
+    "    lla     t1, fault_addr\n"
+    "    sd      t0, 0(t1)\n"
+    "    csrr    t0, mepc\n"
+    "    addi    t0, t0, 4\n"
+    "    csrw    mepc, t0\n"
+    "    ld      t1, 8(sp)\n"
+    "    ld      t0, 0(sp)\n"
+    "    addi    sp, sp, 16\n"
+    "    mret\n");
+
+static void custom_crush(uintptr_t src, uintptr_t dst, int num)
+{
+    asm volatile (
+       ".insn r 0x7b, 6, 38, %0, %1, %2"
+        : :"r"(dst), "r"(src), "r"(num) : "memory");
+}
+
+static void custom_expand(uintptr_t src, uintptr_t dst, int num)
+{
+    asm volatile (
+       ".insn r 0x7b, 6, 54, %0, %1, %2"
+        : :"r"(dst), "r"(src), "r"(num) : "memory");
+}
+
+static void ref_crush(const uint8_t *s, uint8_t *d, int num)
+{
+    int i = 0;
+    int j = 0;
+
+    while (i + 1 < num) {
+        d[j++] = (s[i] & 0x0F) | ((s[i + 1] & 0x0F) << 4);
+        i += 2;
+    }
+    if (i < num) {
+        d[j] = s[i] & 0x0F;
+    }
+}
+
+static void ref_expand(const uint8_t *s, uint8_t *d, int num)
+{
+    for (int i = 0; i < num; i++) {
+        d[2 * i] = s[i] & 0x0F;
+        d[2 * i + 1] = (s[i] >> 4) & 0x0F;
+    }
+}
+
+static void fill(void)
+{
+    uint32_t seed = 233;
+
+    for (int i = 0; i < sizeof(src); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        src[i] = seed >> 24;
+    }
+    memset(dst1, GUARD, sizeof(dst1));
+    memset(dst2, GUARD, sizeof(dst2));
+}
+
+static void compare(uint8_t arr1[], uint8_t arr2[], int n)
+{
+    for (int i = 0; i < n; i++) {
+        crt_assert(arr1[i] == arr2[i]);
+    }
+}
+
+static void test_crush(int soff, int doff, int num)
+{
+    fill();
+    ref_crush(src + soff, dst1 + doff, num);
+    custom_crush((uintptr_t)(src + soff), (uintptr_t)(dst2 + doff), num);
+    /* Also checks that nothing past the last byte was written */
+    compare(dst1, dst2, sizeof(dst1));
+}
+
+static void test_expand(int soff, int doff, int num)
+{
+    fill();
+    ref_expand(src + soff, dst1 + doff, num);
+    custom_expand((uintptr_t)(src + soff), (uintptr_t)(dst2 + doff), num);
+    compare(dst1, dst2, sizeof(dst1));
+}
+
+static void test_fault(void)
+{
+    uint64_t old_mtvec;
+
+    asm volatile("csrr %0, mtvec" : "=r"(old_mtvec));
+    asm volatile("csrw mtvec, %0" : : "r"(fault_trap));
+
+    /* 4 pairs are readable from the mask ROM, the 5th one faults */
+    memset(dst2, GUARD, 16);
+    fault_cause = 0;
+    custom_crush(HOLE_ADDR - 8, (uintptr_t)dst2, 32);
+    crt_assert(fault_cause == CAUSE_LOAD_ACCESS_FAULT);
+    crt_assert(fault_addr == HOLE_ADDR);
+    for (int i = 0; i < 16; i++) {
+        crt_assert(dst2[i] == (i < 4 ? 0 : GUARD));
+    }
+
+    /* 4 bytes are readable from the mask ROM, the 5th one faults */
+    memset(dst2, GUARD, 32);
+    fault_cause = 0;
+    custom_expand(HOLE_ADDR - 4, (uintptr_t)dst2, 16);
+    crt_assert(fault_cause == CAUSE_LOAD_ACCESS_FAULT);
+    crt_assert(fault_addr == HOLE_ADDR);
+    for (int i = 0; i < 32; i++) {
+        crt_assert(dst2[i] == (i < 8 ? 0 : GUARD));
+    }
+
+    asm volatile("csrw mtvec, %0" : : "r"(old_mtvec));
+}
+
+int main(void)
+{
+    printf("Hello, RISC-V G233 Board\n");
+
+    /* Small, odd and page-aligned lengths */
+    test_crush(0, 0, 1);
+    test_crush(0, 0, 31);
+    test_crush(0, 0, 2 * PAGE_SIZE);
+    test_expand(0, 0, 1);
+    test_expand(0, 0, 31);
+    test_expand(0, 0, 2 * PAGE_SIZE);
+
+    /* Source and destination crossing pages at different points */
+    test_crush(PAGE_SIZE - 3, PAGE_SIZE - 5, 3 * PAGE_SIZE + 37);
+    test_crush(PAGE_SIZE - 1, 7, PAGE_SIZE + 2);
+    test_expand(PAGE_SIZE - 3, PAGE_SIZE - 5, 3 * PAGE_SIZE - 9);
+    test_expand(7, PAGE_SIZE - 1, PAGE_SIZE + 2);
+    printf("compare crush/expand successful!\n");
+
+    test_fault();
+    printf("crush/expand fault successful!\n");
+
+    return 0;
+}
@@ -49,9 +49,44 @@ static void test_sort(void)
     compare(arr1, arr2, 16);
 }
 
+/* A constant count loaded right before the insn takes the inline path */
+static void test_sort_inline(void)
+{
+    uint32_t arr1[8] = {0xffffffff, 7, 23, 9, 0x80000000, 33, 4, 7};
+    uint32_t arr2[8] = {0xffffffff, 7, 23, 9, 0x80000000, 33, 4, 7};
+
+    bubble_sort(arr1, 6);
+    asm volatile (
+       "li t0, 6\n"
+       ".insn r 0x7b, 6, 22, t0, %0, t0"
+        : :"r"((uintptr_t)arr2) : "t0", "memory");
+    compare(arr1, arr2, 8);
+}
+
+/* An array crossing a page boundary takes the helper even when inlined */
+static uint32_t page_buf[2048] __attribute__((aligned(4096)));
+
+static void test_sort_inline_cross_page(void)
+{
+    uint32_t init[8] = {41, 0xfffffffe, 3, 19, 0, 7, 1, 5};
+    uint32_t arr1[8];
+    uint32_t *arr2 = &page_buf[1024 - 3];
+
+    memcpy(arr1, init, sizeof(init));
+    memcpy(arr2, init, sizeof(init));
+    bubble_sort(arr1, 8);
+    asm volatile (
+       "li t0, 8\n"
+       ".insn r 0x7b, 6, 22, t0, %0, t0"
+        : :"r"((uintptr_t)arr2) : "t0", "memory");
+    compare(arr1, arr2, 8);
+}
+
 int main(void)
 {
     printf("Hello, RISC-V G233 Board\n");
     test_sort();
+    test_sort_inline();
+    test_sort_inline_cross_page();
     return 0;
 }
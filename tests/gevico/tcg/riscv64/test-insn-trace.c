@@ -0,0 +1,131 @@
+#include "crt.h"
+
+/*
+ * Forward branches, taken and not taken, as translated with
+ * "-accel tcg,superblocks=on" (run-insn-trace-superblocks), where the
+ * fall-through paths become one TB and the taken paths side exits.
+ */
+
+/* Unassigned address right after the mask ROM */
+#define HOLE_ADDR       0x3000
+#define CAUSE_LOAD_ACCESS_FAULT 5
+
+volatile uint64_t fault_cause;
+volatile uint64_t fault_epc;
+void fault_trap(void);
+uint64_t trace_kernel(uint64_t x);
+uint64_t trace_fault(uint64_t base, uint64_t skip);
+void trace_fault_insn(void);
+
+asm(".balign 4\n"
+    "fault_trap:\n"
+    "    addi    sp, sp, -16\n"
+    "    sd      t0, 0(sp)\n"
+    "    sd      t1, 8(sp)\n"
+    "    csrr    t0, mcause\n"
+    "    lla     t1, fault_cause\n"
+    "    sd      t0, 0(t1)\n"
+    "    csrr    t0, mepc\n"
+    "    lla     t1, fault_epc\n"
+    "    sd      t0, 0(t1)\n"
+    "    addi    t0, t0, 4\n"
+    "    csrw    mepc, t0\n"
+    "    ld      t1, 8(sp)\n"
+    "    ld      t0, 0(sp)\n"
+    "    addi    sp, sp, 16\n"
+    "    mret\n");
+
+/* More forward branches than a superblock takes side exits */
+asm(".balign 4\n"
+    "trace_kernel:\n"
+    "    li      a1, 0\n"
+    "    andi    t0, a0, 1\n"
+    "    beqz    t0, 1f\n"
+    "    addi    a1, a1, 1\n"
+    "1:  andi    t0, a0, 2\n"
+    "    beqz    t0, 2f\n"
+    "    addi    a1, a1, 10\n"
+    "2:  andi    t0, a0, 4\n"
+    "    beqz    t0, 3f\n"
+    "    addi    a1, a1, 100\n"
+    "3:  andi    t0, a0, 8\n"
+    "    beqz    t0, 4f\n"
+    "    addi    a1, a1, 1000\n"
+    "4:  andi    t0, a0, 16\n"
+    "    beqz    t0, 5f\n"
+    "    addi    a1, a1, 2000\n"
+    "5:  andi    t0, a0, 32\n"
+    "    beqz    t0, 6f\n"
+    "    addi    a1, a1, 3\n"
+    "6:  mv      a0, a1\n"
+    "    ret\n");
+
+/* A load that faults on the fall-through path of a forward branch */
+asm(".balign 4\n"
+    "trace_fault:\n"
+    "    li      a2, 7\n"
+    "    bnez    a1, 1f\n"
+    "    addi    a2, a2, 1\n"
+    ".option push\n"
+    ".option norvc\n"
+    "trace_fault_insn:\n"
+    "    lw      a3, 0(a0)\n"
+    ".option pop\n"
+    "    addi    a2, a2, 2\n"
+    "1:  mv      a0, a2\n"
+    "    ret\n");
+
+static uint64_t trace_ref(uint64_t x)
+{
+    static const uint64_t weight[] = { 1, 10, 100, 1000, 2000, 3 };
+    uint64_t sum = 0;
+
+    for (int i = 0; i < 6; i++) {
+        if (x & (1 << i)) {
+            sum += weight[i];
+        }
+    }
+    return sum;
+}
+
+static void test_branches(void)
+{
+    for (int round = 0; round < 100; round++) {
+        for (uint64_t x = 0; x < 64; x++) {
+            crt_assert(trace_kernel(x) == trace_ref(x));
+        }
+    }
+}
+
+static void test_fault(void)
+{
+    uint64_t old_mtvec;
+
+    asm volatile("csrr %0, mtvec" : "=r"(old_mtvec));
+    asm volatile("csrw mtvec, %0" : : "r"(fault_trap));
+
+    for (int round = 0; round < 100; round++) {
+        /* Taken: the load is skipped */
+        fault_cause = 0;
+        crt_assert(trace_fault(HOLE_ADDR, 1) == 7);
+        crt_assert(fault_cause == 0);
+
+        /* Not taken: the fault is reported on the load itself */
+        fault_cause = 0;
+        fault_epc = 0;
+        crt_assert(trace_fault(HOLE_ADDR, 0) == 10);
+        crt_assert(fault_cause == CAUSE_LOAD_ACCESS_FAULT);
+        crt_assert(fault_epc == (uintptr_t)trace_fault_insn);
+    }
+
+    asm volatile("csrw mtvec, %0" : : "r"(old_mtvec));
+}
+
+int main(void)
+{
+    test_branches();
+    printf("forward branches successful!\n");
+    test_fault();
+    printf("fault on fall-through path successful!\n");
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "crt.h"
+
+/*
+ * Self-modifying code on a page that also holds data written by the
+ * guest.  Once the page has taken enough writes, QEMU tracks which bytes
+ * of it back translated code: the data writes must then leave the
+ * translation alone, while patching the code must still be seen.
+ */
+
+/* addi a0, zero, imm */
+#define LI_A0(imm)      (((uint32_t)(imm) << 20) | 0x513)
+#define DATA_WRITES     1000
+
+uint64_t smc_func(void);
+extern volatile uint32_t smc_insn;
+extern volatile uint64_t smc_data[];
+
+asm(".pushsection .data\n"
+    ".balign 4096\n"
+    ".option push\n"
+    ".option norvc\n"
+    "smc_func:\n"
+    "smc_insn:\n"
+    "    addi    a0, zero, 1\n"
+    "    ret\n"
+    ".option pop\n"
+    ".balign 64\n"
+    "smc_data:\n"
+    "    .zero   512\n"
+    ".popsection\n");
+
+static void smc_patch(uint32_t insn)
+{
+    smc_insn = insn;
+    asm volatile("fence.i" ::: "memory");
+}
+
+static void test_data_writes(uint64_t expect)
+{
+    for (int i = 0; i < DATA_WRITES; i++) {
+        smc_data[i % 64] = i;
+        if (i % 100 == 0) {
+            crt_assert(smc_func() == expect);
+        }
+    }
+    for (int i = 0; i < 64; i++) {
+        crt_assert(smc_data[i] == DATA_WRITES - 64 + i);
+    }
+}
+
+int main(void)
+{
+    crt_assert(smc_func() == 1);
+    test_data_writes(1);
+    printf("data writes next to code successful!\n");
+
+    for (uint64_t v = 2; v < 10; v++) {
+        smc_patch(LI_A0(v));
+        crt_assert(smc_func() == v);
+        test_data_writes(v);
+    }
+    printf("code patches successful!\n");
+    return 0;
+}
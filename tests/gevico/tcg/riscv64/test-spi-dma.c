@@ -0,0 +1,152 @@
+/*
+ * Test SPI fast-read DMA for G233 platform
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "crt.h"
+
+#define G233_SPI_BASE_ADDR  0x10018000
+
+#define SPI_CR1_OFFSET      0x00
+#define SPI_CR1_MSTR        (1 << 2)
+#define SPI_CR1_SPE         (1 << 6)
+#define SPI_SR_OFFSET       0x08
+#define SPI_SR_RXNE         (1 << 0)
+#define SPI_SR_TXE          (1 << 1)
+#define SPI_SR_DMADONE      (1 << 8)
+#define SPI_SR_DMAERR       (1 << 9)
+#define SPI_DR_OFFSET       0x0C
+#define SPI_CSCTRL_OFFSET   0x10
+#define SPI_CSCTRL_CS0_EN   (1 << 0)
+#define SPI_CSCTRL_CS0_ACT  (1 << 4)
+#define SPI_DMAADDR_OFFSET  0x14
+#define SPI_DMALEN_OFFSET   0x18
+#define SPI_DMACR_OFFSET    0x1C
+#define SPI_DMACR_START     (1 << 0)
+
+#define REG32(addr) (*(volatile uint32_t *)(G233_SPI_BASE_ADDR + (addr)))
+
+#define FLASH_READ_DATA     0x03
+#define FLASH_READ_STATUS   0x05
+#define FLASH_WRITE_ENABLE  0x06
+#define FLASH_PAGE_PROGRAM  0x02
+#define FLASH_SECTOR_ERASE  0x20
+
+#define PAGE_SIZE           256
+#define TEST_LEN            (4 * PAGE_SIZE)
+
+static uint8_t dma_buf[TEST_LEN + 16];
+
+static void cs_assert(void)
+{
+    REG32(SPI_CSCTRL_OFFSET) = SPI_CSCTRL_CS0_EN | SPI_CSCTRL_CS0_ACT;
+}
+
+static void cs_deassert(void)
+{
+    REG32(SPI_CSCTRL_OFFSET) = SPI_CSCTRL_CS0_EN;
+}
+
+static uint8_t spi_transfer(uint8_t data)
+{
+    while (!(REG32(SPI_SR_OFFSET) & SPI_SR_TXE)) {
+    }
+    REG32(SPI_DR_OFFSET) = data;
+    while (!(REG32(SPI_SR_OFFSET) & SPI_SR_RXNE)) {
+    }
+    return REG32(SPI_DR_OFFSET) & 0xFF;
+}
+
+static void flash_cmd_addr(uint8_t cmd, uint32_t addr)
+{
+    spi_transfer(cmd);
+    spi_transfer(addr >> 16);
+    spi_transfer(addr >> 8);
+    spi_transfer(addr);
+}
+
+static void flash_wait_busy(void)
+{
+    uint8_t status;
+
+    do {
+        cs_assert();
+        spi_transfer(FLASH_READ_STATUS);
+        status = spi_transfer(0);
+        cs_deassert();
+    } while (status & 0x01);
+}
+
+static void flash_write_enable(void)
+{
+    cs_assert();
+    spi_transfer(FLASH_WRITE_ENABLE);
+    cs_deassert();
+}
+
+static uint8_t pattern(int i)
+{
+    return (i * 7 + (i >> 8)) & 0xFF;
+}
+
+static void flash_prepare(void)
+{
+    flash_write_enable();
+    cs_assert();
+    flash_cmd_addr(FLASH_SECTOR_ERASE, 0);
+    cs_deassert();
+    flash_wait_busy();
+
+    for (int page = 0; page < TEST_LEN / PAGE_SIZE; page++) {
+        flash_write_enable();
+        cs_assert();
+        flash_cmd_addr(FLASH_PAGE_PROGRAM, page * PAGE_SIZE);
+        for (int i = 0; i < PAGE_SIZE; i++) {
+            spi_transfer(pattern(page * PAGE_SIZE + i));
+        }
+        cs_deassert();
+        flash_wait_busy();
+    }
+}
+
+static void test_dma_read(uint32_t offset, int len)
+{
+    memset(dma_buf, 0xAA, sizeof(dma_buf));
+
+    cs_assert();
+    flash_cmd_addr(FLASH_READ_DATA, offset);
+    REG32(SPI_DMAADDR_OFFSET) = (uint32_t)(uintptr_t)dma_buf;
+    REG32(SPI_DMALEN_OFFSET) = len;
+    REG32(SPI_DMACR_OFFSET) = SPI_DMACR_START;
+    while (!(REG32(SPI_SR_OFFSET) & SPI_SR_DMADONE)) {
+    }
+    cs_deassert();
+
+    crt_assert(!(REG32(SPI_SR_OFFSET) & SPI_SR_DMAERR));
+    crt_assert(REG32(SPI_DMALEN_OFFSET) == 0);
+    REG32(SPI_SR_OFFSET) = SPI_SR_DMADONE;
+    crt_assert(!(REG32(SPI_SR_OFFSET) & SPI_SR_DMADONE));
+
+    for (int i = 0; i < len; i++) {
+        crt_assert(dma_buf[i] == pattern(offset + i));
+    }
+    for (int i = len; i < sizeof(dma_buf); i++) {
+        crt_assert(dma_buf[i] == 0xAA);
+    }
+}
+
+int main(void)
+{
+    printf("G233 SPI Flash DMA Test\n");
+
+    REG32(SPI_CR1_OFFSET) = SPI_CR1_MSTR | SPI_CR1_SPE;
+    flash_prepare();
+
+    test_dma_read(0, TEST_LEN);
+    test_dma_read(3, 300);
+    test_dma_read(PAGE_SIZE + 1, 1);
+
+    printf("SPI flash DMA test successful!\n");
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "crt.h"
+
+/*
+ * Sv39 superpages in S-mode.  The test maps itself with a 1G identity
+ * page and reaches scratch memory through a 2M and a 1G page whose PTEs
+ * it rewrites.  QEMU gives each 4K page of a superpage its own TLB entry,
+ * so a pass over a window refills 512 of them from the one translation;
+ * after the PTE changes, sfence.vma on any single address inside the
+ * superpage must drop all of them.
+ */
+
+#define PTE_V           (1UL << 0)
+#define PTE_R           (1UL << 1)
+#define PTE_W           (1UL << 2)
+#define PTE_X           (1UL << 3)
+#define PTE_A           (1UL << 6)
+#define PTE_D           (1UL << 7)
+/* svade is on: A and D must be set up front or the access faults */
+#define PTE_LEAF        (PTE_V | PTE_R | PTE_W | PTE_X | PTE_A | PTE_D)
+#define PTE(pa, flags)  ((((uint64_t)(pa) >> 12) << 10) | (flags))
+
+#define SATP_SV39       (8UL << 60)
+
+#define PAGE_SIZE       0x1000UL
+#define MEGAPAGE        0x200000UL
+#define GIGAPAGE        0x40000000UL
+#define NPAGES          (MEGAPAGE / PAGE_SIZE)
+
+/* Virtual windows: root_pt[3] points at mega_pt, root_pt[4] is a leaf */
+#define VA_MEGA         0xc0000000UL
+#define VA_GIGA         0x100000000UL
+
+/* Physical scratch memory, clear of the image, stack and FDT */
+#define PA_MEGA_A       0x90000000UL
+#define PA_MEGA_B       0x90200000UL
+#define PA_GIGA_A       0x80000000UL
+#define PA_GIGA_B       0xc0000000UL
+/* Offset of the probed 2M inside either gigapage */
+#define GIGA_PROBE      0x18000000UL
+
+#define TAG_MEGA_A      0xa0
+#define TAG_MEGA_B      0xb0
+#define TAG_MEGA_STORE  0x5a
+#define TAG_GIGA_A      0xa1
+#define TAG_GIGA_B      0xb1
+
+static uint64_t root_pt[512] __attribute__((aligned(4096)));
+static uint64_t mega_pt[512] __attribute__((aligned(4096)));
+
+/* Enter @fn in S-mode with the current satp; returns what @fn returns */
+uint64_t run_smode(uint64_t (*fn)(void));
+
+asm(".pushsection .text\n"
+    ".balign 4\n"
+    "run_smode:\n"
+    "    addi    sp, sp, -32\n"
+    "    sd      ra, 0(sp)\n"
+    "    csrr    t0, mtvec\n"
+    "    sd      t0, 8(sp)\n"
+    "    csrr    t0, mstatus\n"
+    "    sd      t0, 16(sp)\n"
+    "    lla     t0, smode_trap\n"
+    "    csrw    mtvec, t0\n"
+    "    csrw    mepc, a0\n"
+    /* MPP = S; MIE and MPIE off, so only the final ecall traps */
+    "    li      t0, 0x1888\n"
+    "    csrc    mstatus, t0\n"
+    "    li      t0, 0x800\n"
+    "    csrs    mstatus, t0\n"
+    "    lla     ra, smode_done\n"
+    "    mret\n"
+    "smode_done:\n"
+    "    ecall\n"
+    ".balign 4\n"
+    "smode_trap:\n"
+    "    csrr    t0, mcause\n"
+    "    li      t1, 9\n"
+    "    beq     t0, t1, 1f\n"
+    "    j       crt_abort\n"
+    "1:\n"
+    "    ld      t0, 16(sp)\n"
+    "    csrw    mstatus, t0\n"
+    "    ld      t0, 8(sp)\n"
+    "    csrw    mtvec, t0\n"
+    "    ld      ra, 0(sp)\n"
+    "    addi    sp, sp, 32\n"
+    "    ret\n"
+    ".popsection\n");
+
+static inline void sfence_vma(uintptr_t va)
+{
+    asm volatile("sfence.vma %0, zero" :: "r"(va) : "memory");
+}
+
+static uint64_t pattern(uint64_t tag, uint64_t page)
+{
+    return tag << 32 | page;
+}
+
+static void fill(uintptr_t addr, uint64_t tag)
+{
+    for (uint64_t i = 0; i < NPAGES; i++) {
+        *(volatile uint64_t *)(addr + i * PAGE_SIZE) = pattern(tag, i);
+    }
+}
+
+/* Number of 4K pages in the 2M at @addr that do not hold @tag */
+static uint64_t check(uintptr_t addr, uint64_t tag)
+{
+    uint64_t bad = 0;
+
+    for (uint64_t i = 0; i < NPAGES; i++) {
+        bad += *(volatile uint64_t *)(addr + i * PAGE_SIZE) != pattern(tag, i);
+    }
+    return bad;
+}
+
+/*
+ * The S-mode halves below cannot reach the console, so they return the
+ * number of the step that failed instead of asserting.
+ */
+static uint64_t smode_megapage(void)
+{
+    if (check(VA_MEGA, TAG_MEGA_A)) {
+        return 1;
+    }
+
+    /* Retarget the 2M page and flush one 4K page in the middle of it */
+    mega_pt[0] = PTE(PA_MEGA_B, PTE_LEAF);
+    sfence_vma(VA_MEGA + 5 * PAGE_SIZE);
+    if (check(VA_MEGA, TAG_MEGA_B)) {
+        return 2;
+    }
+
+    /* Stores refill from the new translation as well */
+    fill(VA_MEGA, TAG_MEGA_STORE);
+    if (check(PA_MEGA_B, TAG_MEGA_STORE)) {
+        return 3;
+    }
+    if (check(PA_MEGA_A, TAG_MEGA_A)) {
+        return 4;
+    }
+    return 0;
+}
+
+static uint64_t smode_gigapage(void)
+{
+    if (check(VA_GIGA + GIGA_PROBE, TAG_GIGA_A)) {
+        return 1;
+    }
+
+    /* Retarget the 1G page and flush its last 4K page only */
+    root_pt[4] = PTE(PA_GIGA_B, PTE_LEAF);
+    sfence_vma(VA_GIGA + GIGAPAGE - PAGE_SIZE);
+    if (check(VA_GIGA + GIGA_PROBE, TAG_GIGA_B)) {
+        return 2;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    uint64_t step;
+
+    /* Without a matching PMP entry S-mode cannot access anything */
+    asm volatile("csrw pmpaddr0, %0\n"
+                 "csrw pmpcfg0, %1\n"
+                 :: "r"(-1UL), "r"(0x1fUL));
+
+    memset(root_pt, 0, sizeof(root_pt));
+    memset(mega_pt, 0, sizeof(mega_pt));
+    root_pt[2] = PTE(0x80000000UL, PTE_LEAF);
+    root_pt[3] = PTE(mega_pt, PTE_V);
+    root_pt[4] = PTE(PA_GIGA_A, PTE_LEAF);
+    mega_pt[0] = PTE(PA_MEGA_A, PTE_LEAF);
+
+    fill(PA_MEGA_A, TAG_MEGA_A);
+    fill(PA_MEGA_B, TAG_MEGA_B);
+    fill(PA_GIGA_A + GIGA_PROBE, TAG_GIGA_A);
+    fill(PA_GIGA_B + GIGA_PROBE, TAG_GIGA_B);
+
+    asm volatile("csrw satp, %0\n"
+                 "sfence.vma\n"
+                 :: "r"(SATP_SV39 | (uintptr_t)root_pt >> 12) : "memory");
+
+    step = run_smode(smode_megapage);
+    if (step) {
+        printf("2M superpage: step %d failed\n", (int)step);
+    }
+    crt_assert(step == 0);
+    printf("2M superpage remap successful!\n");
+
+    step = run_smode(smode_gigapage);
+    if (step) {
+        printf("1G superpage: step %d failed\n", (int)step);
+    }
+    crt_assert(step == 0);
+    printf("1G superpage remap successful!\n");
+
+    asm volatile("csrw satp, zero\n"
+                 "sfence.vma\n"
+                 ::: "memory");
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+
+# This script checks the output of the mem plugin run with both inline and
+# buffered counting: every access must have been delivered through the
+# buffer exactly once, so both counts have to match.
+
+set -euo pipefail
+
+die()
+{
+    echo "$@" 1>&2
+    exit 1
+}
+
+[ $# -eq 1 ] || die "usage: plugin_out_file"
+
+plugin_out=$1; shift
+
+count()
+{
+    sed -n "s/^$1: \([0-9]*\)$/\1/p" "$plugin_out"
+}
+
+inline=$(count "mem accesses")
+buffered=$(count "buffered mem accesses")
+
+[ -n "$inline" ] || die "no inline count in $plugin_out"
+[ -n "$buffered" ] || die "no buffered count in $plugin_out"
+[ "$inline" -eq "$buffered" ] ||
+    die "buffered count $buffered differs from inline count $inline"
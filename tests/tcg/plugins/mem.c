@@ -29,6 +29,7 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
 typedef struct {
     uint64_t mem_count;
     uint64_t io_count;
+    uint64_t buffered_count;
 } CPUCount;
 
 typedef struct {
@@ -60,7 +61,10 @@ typedef struct {
 static struct qemu_plugin_scoreboard *counts;
 static qemu_plugin_u64 mem_count;
 static qemu_plugin_u64 io_count;
+static qemu_plugin_u64 buffered_count;
 static bool do_inline, do_callback, do_print_accesses, do_region_summary;
+static bool do_buffered;
+static struct qemu_plugin_mem_buffer *buffer;
 static bool do_haddr;
 static enum qemu_plugin_mem_rw rw = QEMU_PLUGIN_MEM_RW;
 
@@ -85,6 +89,10 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
         g_string_printf(out, "mem accesses: %" PRIu64 "\n",
                         qemu_plugin_u64_sum(mem_count));
     }
+    if (do_buffered) {
+        g_string_append_printf(out, "buffered mem accesses: %" PRIu64 "\n",
+                               qemu_plugin_u64_sum(buffered_count));
+    }
     if (do_haddr) {
         g_string_append_printf(out, "io accesses: %" PRIu64 "\n",
                                qemu_plugin_u64_sum(io_count));
@@ -115,6 +123,9 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
         qemu_plugin_outs(out->str);
     }
 
+    if (buffer) {
+        qemu_plugin_mem_buffer_free(buffer);
+    }
     qemu_plugin_scoreboard_free(counts);
 }
 
@@ -254,6 +265,13 @@ static void vcpu_mem(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
     }
 }
 
+static void vcpu_mem_buffered(unsigned int cpu_index,
+                              const qemu_plugin_mem_record *records,
+                              size_t n, void *udata)
+{
+    qemu_plugin_u64_add(buffered_count, cpu_index, n);
+}
+
 static void print_access(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
                          uint64_t vaddr, void *udata)
 {
@@ -306,6 +324,9 @@ static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
                 QEMU_PLUGIN_INLINE_ADD_U64,
                 mem_count, 1);
         }
+        if (do_buffered) {
+            qemu_plugin_register_vcpu_mem_buffer(insn, buffer, rw, 0);
+        }
         if (do_callback || do_region_summary) {
             qemu_plugin_register_vcpu_mem_cb(insn, vcpu_mem,
                                              QEMU_PLUGIN_CB_NO_REGS,
@@ -359,6 +380,11 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
                 fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
                 return -1;
             }
+        } else if (g_strcmp0(tokens[0], "buffered") == 0) {
+            if (!qemu_plugin_bool_parse(tokens[0], tokens[1], &do_buffered)) {
+                fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
+                return -1;
+            }
         } else if (g_strcmp0(tokens[0], "print-accesses") == 0) {
             if (!qemu_plugin_bool_parse(tokens[0], tokens[1],
                                         &do_print_accesses)) {
@@ -400,6 +426,12 @@ QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
     mem_count = qemu_plugin_scoreboard_u64_in_struct(
         counts, CPUCount, mem_count);
     io_count = qemu_plugin_scoreboard_u64_in_struct(counts, CPUCount, io_count);
+    buffered_count = qemu_plugin_scoreboard_u64_in_struct(
+        counts, CPUCount, buffered_count);
+    if (do_buffered) {
+        buffer = qemu_plugin_mem_buffer_new(id, 4096, vcpu_mem_buffered,
+                                            NULL);
+    }
     qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
     qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
     return 0;
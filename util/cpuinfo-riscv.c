@@ -37,7 +37,7 @@ static void sigill_handler(int signo, siginfo_t *si, void *data)
 unsigned __attribute__((constructor)) cpuinfo_init(void)
 {
     unsigned left = CPUINFO_ZBA | CPUINFO_ZBB | CPUINFO_ZBS
-                  | CPUINFO_ZICOND | CPUINFO_ZVE64X;
+                  | CPUINFO_ZICOND | CPUINFO_ZVE64X | CPUINFO_ZVKB;
     unsigned info = cpuinfo;
 
     if (info) {
@@ -60,6 +60,9 @@ unsigned __attribute__((constructor)) cpuinfo_init(void)
 #if defined(__riscv_arch_test) && \
     (defined(__riscv_vector) || defined(__riscv_zve64x))
     info |= CPUINFO_ZVE64X;
+#endif
+#if defined(__riscv_arch_test) && defined(__riscv_zvkb)
+    info |= CPUINFO_ZVKB;
 #endif
     left &= ~info;
 
@@ -85,6 +88,9 @@ unsigned __attribute__((constructor)) cpuinfo_init(void)
             info |= pair.value & RISCV_HWPROBE_IMA_V ? CPUINFO_ZVE64X : 0;
 #ifdef RISCV_HWPROBE_EXT_ZVE64X
             info |= pair.value & RISCV_HWPROBE_EXT_ZVE64X ? CPUINFO_ZVE64X : 0;
+#endif
+#ifdef RISCV_HWPROBE_EXT_ZVKB
+            info |= pair.value & RISCV_HWPROBE_EXT_ZVKB ? CPUINFO_ZVKB : 0;
 #endif
         }
     }
@@ -94,7 +100,7 @@ unsigned __attribute__((constructor)) cpuinfo_init(void)
      * We only detect support for vectors with hwprobe.  All kernels with
      * support for vectors in userspace also support the hwprobe syscall.
      */
-    left &= ~CPUINFO_ZVE64X;
+    left &= ~(CPUINFO_ZVE64X | CPUINFO_ZVKB);
 
     if (left) {
         struct sigaction sa_old, sa_new;
@@ -157,6 +163,8 @@ unsigned __attribute__((constructor)) cpuinfo_init(void)
         assert(is_power_of_2(vlenb));
         /* Cache VLEN in a convenient form. */
         riscv_lg2_vlenb = ctz32(vlenb);
+    } else {
+        info &= ~CPUINFO_ZVKB;
     }
 
     info |= CPUINFO_ALWAYS;
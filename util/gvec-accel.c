@@ -0,0 +1,43 @@
+/*
+ * Host-vector acceleration of wide element-wise operations
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/gvec-accel.h"
+#include "host/cpuinfo.h"
+
+typedef struct GVecAccelImpl {
+    const char *name;
+    GVecAccelFn fns[GVEC_ACCEL_NB_OPS];
+} GVecAccelImpl;
+
+/* Entry 0 never accelerates anything: the callers loop themselves. */
+#define GVEC_ACCEL_NONE  { .name = "none" }
+
+#include "host/gvec-accel.c.inc"
+
+const GVecAccelFn *gvec_accel_fns = gvec_accel_impls[0].fns;
+static unsigned gvec_accel_index;
+
+const char *gvec_accel_name(void)
+{
+    return gvec_accel_impls[gvec_accel_index].name;
+}
+
+bool test_gvec_accel_next(void)
+{
+    if (gvec_accel_index != 0) {
+        gvec_accel_fns = gvec_accel_impls[--gvec_accel_index].fns;
+        return true;
+    }
+    return false;
+}
+
+static void __attribute__((constructor)) init_gvec_accel(void)
+{
+    gvec_accel_index = best_gvec_accel();
+    gvec_accel_fns = gvec_accel_impls[gvec_accel_index].fns;
+}